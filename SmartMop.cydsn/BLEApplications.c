@@ -43,27 +43,87 @@
 *****************************************************************************/
 #include <main.h>
 #include <BLEApplications.h>
+#include <calibration.h>
+#include <scheduler.h>
+#include <power.h>
+#include <profile.h>
+#include <history.h>
+#include <notify.h>
+#include <stream.h>
 
 /*************************Variables Declaration*************************************************************************/
 uint8 StartAdvertisement = FALSE; //This flag is used to start advertisement
 uint8 DeviceConnected = FALSE; //This flag is set when a Central device is connected
-uint8 BLEStackStatus = FALSE; //Variable store the BLE stack status
-uint8 ConnectionParametersUpdateRequired = TRUE; //This flag is used to send the connection parameters update
+uint8 BLEStackStatus = CYBLE_STACK_STATE_FREE; //Variable store the BLE stack status, the notification queue drains while it is free
+uint8 ConnParamProfile = CONN_PROFILE_NONE; //Connection parameter profile accepted by the Central device
+uint8 ConnParamRequested = CONN_PROFILE_NONE; //Profile of the request waiting for a response, CONN_PROFILE_NONE if none
+uint8 ConnParamRejected = CONN_PROFILE_NONE; //Profile of the last rejected request
+uint16 ConnParamRequestCount = 0u; //Connection parameter update requests sent
+uint16 ConnParamAcceptCount = 0u; //Requests accepted by the Central device
+uint16 ConnParamRejectCount = 0u; //Requests rejected by the Central device
+uint16 ConnInterval = 0u; //Connection interval in use, in 1.25 ms
+uint16 ConnLatency = 0u; //Slave latency in use
 uint8 CapSenseNotificationEnabled = FALSE; //This flag is set when the Central device writes to CCCD to enable temperature notification
 uint8 UpdateCapSenseNotificationAttribute = FALSE; //This flags is used to update the respective temperature CCCD value
 uint8 CapSenseNotificationCCCDValue[0x02];
+uint8 LevelNotificationEnabled = FALSE; //This flag is set when the Central device writes to the CCCD of the packed level characteristic
+uint8 LevelNotificationCCCDValue[0x02];
+uint8 LevelNotificationSequence = 0u; //Sequence number of the next packed level notification handed to the stack
+uint8 HistoryNotificationEnabled = FALSE; //This flag is set when the Central device writes to the CCCD of the history characteristic
+uint8 HistoryNotificationCCCDValue[0x02];
+uint8 StreamNotificationEnabled = FALSE; //This flag is set when the Central device writes to the CCCD of the raw sensor stream characteristic
+uint8 StreamNotificationCCCDValue[0x02];
+uint16 NegotiatedMtu = DEFAULT_MTU_LEN; //ATT MTU of the connection
+uint8 BroadcastEnabled = TRUE; //Advertise all the time while disconnected, so scanners read the level without connecting
+uint8 BroadcastRestart = FALSE; //This flag is used to restart the slow broadcast advertising
+uint8 BroadcastAdvertising = FALSE; //Set while the slow broadcast advertising runs, the status LED only blinks in discoverable mode
+uint8 BroadcastStopping = FALSE; //Set while the slow broadcast advertising stops, so a BMI270 wake can start discoverable mode
+uint8 BroadcastCounter = 0u; //Rolling counter of the broadcast data
+uint8 BroadcastFits = FALSE; //Set when the level broadcast fits in the advertising data of the BLE component. Broadcasting stays off if it does not
+int32 notifyDeadband = NOTIFICATION_DEADBAND; //Smallest level change that is notified, fixed precision 24.8
+uint32 notifyMinIntervalMs = NOTIFICATION_INTERVAL_MS; //Minimum time between two level notifications
+uint32 notifyHeartbeatMs = NOTIFICATION_HEARTBEAT_MS; //Longest time without a level notification
+uint32 notifySentCount = 0u; //Level notifications sent for a level change
+uint32 notifyHeartbeatCount = 0u; //Level notifications sent because the last one was notifyHeartbeatMs old
+uint32 notifyCoalescedCount = 0u; //Level changes merged into a notification that was already pending
 extern int32 previousLevelPercent;
 extern int32 levelPercent;
+extern int32 levelMm;
+extern uint8 sensorActiveCount;
+extern uint8 motionSloshing;
+extern uint8 calScaleState;
+extern uint8 powerBatteryPercent;
+extern volatile uint32 systemTimeMs;
+extern uint8 streamFields;
+
+/* Requested parameters of each connection parameter profile */
+static const CYBLE_GAP_CONN_UPDATE_PARAM_T CYCODE ConnParamProfiles[CONN_PROFILE_COUNT] = {
+    {CONN_PARAM_ACTIVE_MIN_CONN_INTERVAL, CONN_PARAM_ACTIVE_MAX_CONN_INTERVAL, CONN_PARAM_ACTIVE_SLAVE_LATENCY, CONN_PARAM_ACTIVE_SUPRV_TIMEOUT},
+    {CONN_PARAM_IDLE_MIN_CONN_INTERVAL, CONN_PARAM_IDLE_MAX_CONN_INTERVAL, CONN_PARAM_IDLE_SLAVE_LATENCY, CONN_PARAM_IDLE_SUPRV_TIMEOUT}};
 
 /*****************************************************************************
 * Static variables 
 *****************************************************************************/
 static CYBLE_CONN_HANDLE_T ConnectionHandle; //This handle stores the connection parameters
 static CYBLE_GATTS_WRITE_REQ_PARAM_T *WriteRequestedParameter; //Variable to store the data received as part of the Write request event
-static CYBLE_GATTS_HANDLE_VALUE_NTF_T CapSenseNotificationHandle;
+static CYBLE_GATTS_ERR_PARAM_T WriteErrorParameter; //Error response to a write request with an invalid value
 static CYBLE_GATT_HANDLE_VALUE_PAIR_T CapSenseNotificationCCCDHandle; //This handle is used to update the temperature CCCD
-static CYBLE_GAP_CONN_UPDATE_PARAM_T ConnectionParametersHandle = {CONN_PARAM_UPDATE_MIN_CONN_INTERVAL, CONN_PARAM_UPDATE_MAX_CONN_INTERVAL,
-    CONN_PARAM_UPDATE_SLAVE_LATENCY, CONN_PARAM_UPDATE_SUPRV_TIMEOUT}; //Connection Parameter update values
+static CYBLE_GATT_HANDLE_VALUE_PAIR_T LevelNotificationCCCDHandle; //This handle is used to update the packed level CCCD
+static CYBLE_GATT_HANDLE_VALUE_PAIR_T HistoryNotificationCCCDHandle; //This handle is used to update the history CCCD
+static CYBLE_GATT_HANDLE_VALUE_PAIR_T StreamNotificationCCCDHandle; //This handle is used to update the raw sensor stream CCCD
+static CYBLE_GATT_HANDLE_VALUE_PAIR_T CalibrationHandle; //This handle is used to update the calibration status
+static CYBLE_GATT_HANDLE_VALUE_PAIR_T EstimatorHandle; //This handle is used to update the time to empty and consumption rate
+static CYBLE_GATT_HANDLE_VALUE_PAIR_T DiagnosticsHandle; //This handle is used to update the state residency diagnostics
+static CYBLE_GAP_CONN_UPDATE_PARAM_T ConnectionParametersHandle; //Connection Parameter update values
+static uint32 ConnLastActivityMs = 0u; //Time of the last notification or history transfer
+static uint32 ConnParamRequestMs = 0u; //Time of the last request sent
+static uint32 ConnParamRejectMs = 0u; //Time of the last rejected request
+static uint8 BroadcastOffset = 0u; //Offset of the manufacturer data in the advertising data, 0 if it does not fit
+static int32 BroadcastLevelPercent = -1; //Level in the broadcast data
+static uint8 NotifyPending = FALSE; //A level change waits for the minimum notification interval
+static uint8 NotifyFlags = 0u; //Flags in the last level notification
+static uint32 NotifyLastMs = 0u; //Time of the last level notification
+static uint8 BroadcastFlags = 0u; //Flags in the broadcast data
 /***********************************************************************************************************************/
 
 
@@ -82,6 +142,8 @@ static CYBLE_GAP_CONN_UPDATE_PARAM_T ConnectionParametersHandle = {CONN_PARAM_UP
 *************************************************************************************************************************/
 void CustomEventHandler(uint32 Event, void *EventParameter)
 {
+    PROFILE_BEGIN(PROFILE_PROBE_BLE_EVENT);
+    
     switch(Event)
 	{
         /**********************************************************
@@ -89,6 +151,21 @@ void CustomEventHandler(uint32 Event, void *EventParameter)
         ***********************************************************/
 		case CYBLE_EVT_STACK_ON: //This event is received when the BLE component is started			
             //StartAdvertisement = TRUE; //Set the advertisement flag
+            
+            /* Append the level broadcast to the advertising data of the BLE component. The device name
+            *  is in the scan response packet, so the flags and the service UUID leave room for it */
+            if((cyBle_discoveryModeInfo.advData->advDataLen + BROADCAST_AD_LEN) <= CYBLE_GAP_MAX_ADV_DATA_LEN)
+            {
+                BroadcastOffset = cyBle_discoveryModeInfo.advData->advDataLen + 2u;
+                cyBle_discoveryModeInfo.advData->advData[BroadcastOffset - 2u] = BROADCAST_AD_LEN - 1u;
+                cyBle_discoveryModeInfo.advData->advData[BroadcastOffset - 1u] = ADV_TYPE_MANUFACTURER_DATA;
+                cyBle_discoveryModeInfo.advData->advData[BroadcastOffset + BROADCAST_COMPANY] = LO8(BROADCAST_COMPANY_ID);
+                cyBle_discoveryModeInfo.advData->advData[BroadcastOffset + BROADCAST_COMPANY + 1u] = HI8(BROADCAST_COMPANY_ID);
+                cyBle_discoveryModeInfo.advData->advDataLen += BROADCAST_AD_LEN;
+                BroadcastFits = TRUE;
+                UpdateBroadcastData();
+            }
+            BroadcastRestart = BroadcastEnabled && BroadcastFits;
 		break;
             
         case CYBLE_EVT_STACK_BUSY_STATUS: //This event is generated when the internal stack buffer is full and no more data can be accepted or the stack has buffer available and can accept data
@@ -102,11 +179,15 @@ void CustomEventHandler(uint32 Event, void *EventParameter)
             if(CyBle_GetState() == CYBLE_STATE_DISCONNECTED)
             {
                 //StartAdvertisement = TRUE; //Set the advertisement flag
+                BroadcastAdvertising = FALSE;
+                BroadcastRestart = BroadcastEnabled && BroadcastFits; //Keep broadcasting after the advertising timeout
+                BroadcastStopping = FALSE;
             }
         break;
 			
 		case CYBLE_EVT_GAP_DEVICE_DISCONNECTED: //This event is received when the device is disconnected
 			//StartAdvertisement = TRUE; //Set the advertisement flag
+            BroadcastRestart = BroadcastEnabled && BroadcastFits;
         break;
 
         /**********************************************************
@@ -116,18 +197,46 @@ void CustomEventHandler(uint32 Event, void *EventParameter)
 			ConnectionHandle = *(CYBLE_CONN_HANDLE_T *)EventParameter; //Update the attribute handle on GATT connection
 			
 			DeviceConnected = TRUE; //Set device connection status flag
+            BroadcastAdvertising = FALSE;
             
+            /* Service discovery follows, ask for short intervals first. Then pace the level notifications */
+            ConnLastActivityMs = systemTimeMs;
+            SchedulerStart(SCHEDULER_TASK_CONN, CONN_UPDATE_DELAY_MS, CONN_PARAM_CHECK_PERIOD_MS);
+            SchedulerStart(SCHEDULER_TASK_NOTIFY, notifyHeartbeatMs, notifyHeartbeatMs);
+            SchedulerStart(SCHEDULER_TASK_DIAG, 0u, POWER_DIAG_PERIOD_MS);
         break;
 			
         case CYBLE_EVT_GATT_DISCONNECT_IND: //This event is received when device is disconnected
 			DeviceConnected = FALSE; //Clear device connection status flag
             CapSenseNotificationEnabled = FALSE;
+            LevelNotificationEnabled = FALSE;
+            HistoryNotificationEnabled = FALSE;
+            StreamNotificationEnabled = FALSE;
+            StreamStop();
+            NegotiatedMtu = DEFAULT_MTU_LEN;
             UpdateCapSenseNotificationAttribute = TRUE;
-            previousLevelPercent = ZERO;
-            levelPercent = ZERO;
-            ConnectionParametersUpdateRequired = TRUE; //Set the Connection Parameters Update flag
+            previousLevelPercent = ZERO; //The next connection gets the level right away, levelPercent keeps the measurement
+            NotifyPending = FALSE;
+            ConnParamProfile = CONN_PROFILE_NONE; //The next connection negotiates again
+            ConnParamRequested = CONN_PROFILE_NONE;
+            ConnParamRejected = CONN_PROFILE_NONE;
             UpdateNotificationCCCDAttribute(); //Update the CCCD writing by the Central device
+            SchedulerStop(SCHEDULER_TASK_CONN);
+            SchedulerStop(SCHEDULER_TASK_NOTIFY);
+            SchedulerStop(SCHEDULER_TASK_DIAG);
+            SchedulerStop(SCHEDULER_TASK_SYNC);
+            NotifyQueueClear(); //Queued notifications belong to the closed link
+            BLEStackStatus = CYBLE_STACK_STATE_FREE;
 		break;
+        
+        case CYBLE_EVT_GATTS_XCNHG_MTU_REQ: //This event is received when the Central device exchanges the MTU, the stack responds with MTU_XCHANGE_DATA_LEN
+            /* The connection uses the smaller of the two MTUs */
+            NegotiatedMtu = ((CYBLE_GATT_XCHG_MTU_PARAM_T *)EventParameter)->mtu;
+            if(NegotiatedMtu > MTU_XCHANGE_DATA_LEN)
+            {
+                NegotiatedMtu = MTU_XCHANGE_DATA_LEN;
+            }
+        break;
             
         case CYBLE_EVT_GATTS_WRITE_REQ: //When this event is triggered, the peripheral has received a write command on the custom characteristic
 			/* Extract the write value from the event parameter */
@@ -140,6 +249,63 @@ void CustomEventHandler(uint32 Event, void *EventParameter)
 				
 				/* Set flag to allow CCCD to be updated for next read operation */
 				UpdateCapSenseNotificationAttribute = TRUE;
+                SchedulerStart(SCHEDULER_TASK_CONN, 0u, CONN_PARAM_CHECK_PERIOD_MS);
+            }
+            else if(WriteRequestedParameter->handleValPair.attrHandle == LEVEL_CCC_HANDLE)
+            {
+                LevelNotificationEnabled = WriteRequestedParameter->handleValPair.value.val[CCC_DATA_INDEX];
+                
+                /* Send the current level right away, then on every change */
+                NotifyPending = TRUE;
+                SchedulerStart(SCHEDULER_TASK_NOTIFY, 0u, notifyHeartbeatMs);
+                UpdateCapSenseNotificationAttribute = TRUE;
+                SchedulerStart(SCHEDULER_TASK_CONN, 0u, CONN_PARAM_CHECK_PERIOD_MS);
+            }
+            else if(WriteRequestedParameter->handleValPair.attrHandle == HISTORY_CCC_HANDLE)
+            {
+                HistoryNotificationEnabled = WriteRequestedParameter->handleValPair.value.val[CCC_DATA_INDEX];
+                
+                /* Send the history recorded while disconnected */
+                UpdateCapSenseNotificationAttribute = TRUE;
+                SchedulerStart(SCHEDULER_TASK_CONN, 0u, CONN_PARAM_CHECK_PERIOD_MS);
+                if(HistoryNotificationEnabled)
+                {
+                    SchedulerStart(SCHEDULER_TASK_SYNC, 0u, HISTORY_SYNC_PERIOD_MS);
+                }
+            }
+            else if(WriteRequestedParameter->handleValPair.attrHandle == STREAM_CCC_HANDLE)
+            {
+                StreamNotificationEnabled = WriteRequestedParameter->handleValPair.value.val[CCC_DATA_INDEX];
+                
+                /* Stream every processed frame, starting with a keyframe. Refused below STREAM_MTU_MIN,
+                *  the CCCD then reads back disabled */
+                if(StreamNotificationEnabled)
+                {
+                    StreamNotificationEnabled = StreamStart();
+                }
+                else
+                {
+                    StreamStop();
+                }
+                UpdateCapSenseNotificationAttribute = TRUE;
+            }
+            else if(WriteRequestedParameter->handleValPair.attrHandle == STREAM_CHAR_HANDLE)
+            {
+                /* The value is one byte of STREAM_FIELD_ bits, reject any other length instead of reading a stale byte */
+                if(WriteRequestedParameter->handleValPair.value.len != STREAM_WRITE_DATA_LEN)
+                {
+                    WriteErrorParameter.opcode = CYBLE_GATT_WRITE_REQ;
+                    WriteErrorParameter.attrHandle = STREAM_CHAR_HANDLE;
+                    WriteErrorParameter.errorCode = CYBLE_GATT_ERR_INVALID_ATTRIBUTE_LEN;
+                    CyBle_GattsErrorRsp(ConnectionHandle, &WriteErrorParameter);
+                    break;
+                }
+                streamFields = WriteRequestedParameter->handleValPair.value.val[0] & STREAM_FIELD_ALL; //STREAM_FIELD_ bits to stream
+            }
+            else if((WriteRequestedParameter->handleValPair.attrHandle == CALIBRATION_CHAR_HANDLE) &&
+                (WriteRequestedParameter->handleValPair.value.val[0] == CALIBRATION_CMD_FULL_SCALE))
+            {
+                CalibrationStartFullScale(); //Start full-tank scaling, the tank must be full
             }
 			    
             /* Send response to the write command received */
@@ -151,21 +317,39 @@ void CustomEventHandler(uint32 Event, void *EventParameter)
         ***********************************************************/
             
         case CYBLE_EVT_L2CAP_CONN_PARAM_UPDATE_RSP: //This event is generated when the L2CAP connection parameter update response received
-            ConnectionParametersUpdateRequired = FALSE; //Clear the Connection Parameters Update flag
+            if(*(uint16 *)EventParameter == CONN_PARAM_ACCEPTED)
+            {
+                ConnParamProfile = ConnParamRequested;
+                ConnParamAcceptCount++;
+            }
+            else
+            {
+                /* Keep the current parameters, the same request is sent again after CONN_PARAM_RETRY_MS */
+                ConnParamRejected = ConnParamRequested;
+                ConnParamRejectMs = systemTimeMs;
+                ConnParamRejectCount++;
+            }
+            ConnParamRequested = CONN_PROFILE_NONE;
+        break;
+        
+        case CYBLE_EVT_GAP_CONNECTION_UPDATE_COMPLETE: //This event is generated when the new connection parameters are in use
+            ConnInterval = ((CYBLE_GAP_CONN_PARAM_UPDATED_IN_CONTROLLER_T *)EventParameter)->connIntv;
+            ConnLatency = ((CYBLE_GAP_CONN_PARAM_UPDATED_IN_CONTROLLER_T *)EventParameter)->connLatency;
         break;
 			
         default:
         break;
 	}
+    
+    PROFILE_END(PROFILE_PROBE_BLE_EVENT);
 }
 
 /*******************************************************************************
 * Function Name: SendCapSenseNotification
 ********************************************************************************
 * Summary:
-* Send CapSense Slider data as BLE Notifications. This function updates
-* the notification handle with data and triggers the BLE component to send 
-* notification
+* Send CapSense Slider data as BLE Notifications. The value is queued and
+* sent when the stack has free buffers, a value still waiting is replaced
 *
 * Parameters:
 *  CapSenseSliderData:	CapSense slider value	
@@ -177,15 +361,194 @@ void CustomEventHandler(uint32 Event, void *EventParameter)
 void SendCapSenseNotification(uint8 CapSenseSliderData)
 {
     
-    /* Update notification handle with CapSense slider data*/
-    	CapSenseNotificationHandle.attrHandle = CAPSENSE_SLIDER_CHAR_HANDLE;				
-    	CapSenseNotificationHandle.value.val = &CapSenseSliderData;
-    	CapSenseNotificationHandle.value.len = CAPSENSE_CHAR_DATA_LEN;
-    	
-    	/* Send notifications. */
-    	CyBle_GattsNotification(cyBle_connHandle, &CapSenseNotificationHandle);
-   
+    /* Queue the notification, only the latest slider value is sent */
+    NotifyQueuePut(CAPSENSE_SLIDER_CHAR_HANDLE, &CapSenseSliderData, CAPSENSE_CHAR_DATA_LEN, TRUE, NULL, NULL);
+
+}
+
+
+/*******************************************************************************
+* Function Name: LevelPercent88
+********************************************************************************
+* Summary:
+* Level in percent in fixed precision 8.8, which is enough for 0 to 100 percent.
+*
+* Parameters:
+*  void
+*
+* Return:
+*  uint16: level in percent, fixed precision 8.8
+*
+*******************************************************************************/
+static uint16 LevelPercent88(void)
+{
+    if(levelPercent < 0)
+    {
+        return 0u;
+    }
+    return (levelPercent > 0xFFFF) ? 0xFFFFu : (uint16)levelPercent;
+}
+
+
+/*******************************************************************************
+* Function Name: LevelFlags
+********************************************************************************
+* Summary:
+* LEVEL_NTF_FLAG_ bits of the current level state.
+*
+* Parameters:
+*  void
+*
+* Return:
+*  uint8: LEVEL_NTF_FLAG_ bits
+*
+*******************************************************************************/
+static uint8 LevelFlags(void)
+{
+    uint8 Flags = 0u;
+    
+    if(motionSloshing)
+    {
+        Flags |= LEVEL_NTF_FLAG_SLOSHING;
+    }
+    if(calScaleState == CAL_SCALE_RUNNING)
+    {
+        Flags |= LEVEL_NTF_FLAG_FULL_SCALE;
+    }
+    return Flags;
+}
+
+
+/*******************************************************************************
+* Function Name: StampLevelNotification
+********************************************************************************
+* Summary:
+* Send handler of the packed level notification. The sequence number is written
+* when the notification is handed to the stack, so a level that replaced a
+* queued one does not leave a gap.
+*
+* Parameters:
+*  uint8 *LevelData: value of the queued notification
+*
+* Return:
+*  void
+*
+*******************************************************************************/
+static void StampLevelNotification(uint8 LevelData[])
+{
+    LevelData[LEVEL_NTF_SEQUENCE] = LevelNotificationSequence;
+}
+
+
+/*******************************************************************************
+* Function Name: LevelNotificationDone
+********************************************************************************
+* Summary:
+* Done handler of the packed level notification. The sequence number advances
+* once the notification left the queue, so a notification the stack refused or
+* that was dropped on disconnect shows as a gap.
+*
+* Parameters:
+*  const uint8 *LevelData: value of the notification
+*  uint8 Sent: TRUE if the stack accepted it
+*
+* Return:
+*  void
+*
+*******************************************************************************/
+static void LevelNotificationDone(const uint8 LevelData[], uint8 Sent)
+{
+    (void)LevelData;
+    (void)Sent;
+    
+    LevelNotificationSequence++;
+}
 
+
+/*******************************************************************************
+* Function Name: SendLevelNotification
+********************************************************************************
+* Summary:
+* Send the level, the submerged sensor count, the slosh and full-tank scaling
+* state, the battery level and a timestamp in one notification of the packed
+* level characteristic, in the layout of the LEVEL_NTF offsets. The Central
+* device gets everything in one PDU instead of reading several attributes.
+* The notification is queued, a level still waiting for the stack is replaced.
+* The sequence number is stamped when the stack gets the notification.
+*
+* Parameters:
+*  void
+*
+* Return:
+*  void
+*
+*******************************************************************************/
+void SendLevelNotification(void)
+{
+    uint8 LevelData[LEVEL_NTF_LEN];
+    uint16 Percent = LevelPercent88();
+    uint8 Flags = LevelFlags();
+    
+    LevelData[LEVEL_NTF_SEQUENCE] = 0u; //Stamped by StampLevelNotification
+    LevelData[LEVEL_NTF_LEVEL_MM] = LO8(levelMm);
+    LevelData[LEVEL_NTF_LEVEL_MM + 1u] = HI8(levelMm);
+    LevelData[LEVEL_NTF_LEVEL_MM + 2u] = LO8(HI16(levelMm));
+    LevelData[LEVEL_NTF_LEVEL_MM + 3u] = HI8(HI16(levelMm));
+    LevelData[LEVEL_NTF_PERCENT] = LO8(Percent);
+    LevelData[LEVEL_NTF_PERCENT + 1u] = HI8(Percent);
+    LevelData[LEVEL_NTF_ACTIVE_COUNT] = sensorActiveCount;
+    LevelData[LEVEL_NTF_FLAGS] = Flags;
+    LevelData[LEVEL_NTF_BATTERY] = powerBatteryPercent;
+    LevelData[LEVEL_NTF_TIMESTAMP] = LO8(systemTimeMs);
+    LevelData[LEVEL_NTF_TIMESTAMP + 1u] = HI8(systemTimeMs);
+    LevelData[LEVEL_NTF_TIMESTAMP + 2u] = LO8(HI16(systemTimeMs));
+    LevelData[LEVEL_NTF_TIMESTAMP + 3u] = HI8(HI16(systemTimeMs));
+    
+    NotifyQueuePut(LEVEL_CHAR_HANDLE, LevelData, LEVEL_CHAR_DATA_LEN, TRUE, StampLevelNotification, LevelNotificationDone);
+}
+
+
+/*******************************************************************************
+* Function Name: UpdateBroadcastData
+********************************************************************************
+* Summary:
+* Refresh the level broadcast in the manufacturer data of the advertising packet
+* when the level or its state changed. The advertising data is updated in place,
+* so a passive scanner reads the level of every device in range without a
+* connection. The rolling counter changes with every update.
+*
+* Parameters:
+*  void
+*
+* Return:
+*  void
+*
+*******************************************************************************/
+void UpdateBroadcastData(void)
+{
+    uint8 *BroadcastData = &cyBle_discoveryModeInfo.advData->advData[BroadcastOffset];
+    uint16 Percent = LevelPercent88();
+    uint8 Flags = LevelFlags();
+    
+    if((BroadcastOffset == 0u) ||
+        ((levelPercent == BroadcastLevelPercent) && (Flags == BroadcastFlags) && (BroadcastData[BROADCAST_BATTERY] == powerBatteryPercent)))
+    {
+        return;
+    }
+    BroadcastLevelPercent = levelPercent;
+    BroadcastFlags = Flags;
+    
+    BroadcastData[BROADCAST_PERCENT] = LO8(Percent);
+    BroadcastData[BROADCAST_PERCENT + 1u] = HI8(Percent);
+    BroadcastData[BROADCAST_FLAGS] = Flags;
+    BroadcastData[BROADCAST_BATTERY] = powerBatteryPercent;
+    BroadcastData[BROADCAST_COUNTER] = ++BroadcastCounter;
+    
+    /* Data of a stopped advertiser is used at the next start */
+    if(CyBle_GetState() == CYBLE_STATE_ADVERTISING)
+    {
+        CyBle_GappUpdateAdvScanData(&cyBle_discoveryModeInfo);
+    }
 }
 
 
@@ -220,17 +583,119 @@ void UpdateNotificationCCCDAttribute(void)
         /* Send the updated handle as part of attribute for notifications */
     	CyBle_GattsWriteAttributeValue(&CapSenseNotificationCCCDHandle, 0x00, &ConnectionHandle, CYBLE_GATT_DB_LOCALLY_INITIATED);
         
+        /* Same for the packed level characteristic */
+        LevelNotificationCCCDValue[0] = LevelNotificationEnabled;
+        LevelNotificationCCCDValue[1] = 0x00;
+        LevelNotificationCCCDHandle.attrHandle = LEVEL_CCC_HANDLE;
+        LevelNotificationCCCDHandle.value.val = LevelNotificationCCCDValue;
+        LevelNotificationCCCDHandle.value.len = CCC_DATA_LEN;
+        CyBle_GattsWriteAttributeValue(&LevelNotificationCCCDHandle, 0x00, &ConnectionHandle, CYBLE_GATT_DB_LOCALLY_INITIATED);
+        
+        HistoryNotificationCCCDValue[0] = HistoryNotificationEnabled;
+        HistoryNotificationCCCDValue[1] = 0x00;
+        HistoryNotificationCCCDHandle.attrHandle = HISTORY_CCC_HANDLE;
+        HistoryNotificationCCCDHandle.value.val = HistoryNotificationCCCDValue;
+        HistoryNotificationCCCDHandle.value.len = CCC_DATA_LEN;
+        CyBle_GattsWriteAttributeValue(&HistoryNotificationCCCDHandle, 0x00, &ConnectionHandle, CYBLE_GATT_DB_LOCALLY_INITIATED);
+        
+        StreamNotificationCCCDValue[0] = StreamNotificationEnabled;
+        StreamNotificationCCCDValue[1] = 0x00;
+        StreamNotificationCCCDHandle.attrHandle = STREAM_CCC_HANDLE;
+        StreamNotificationCCCDHandle.value.val = StreamNotificationCCCDValue;
+        StreamNotificationCCCDHandle.value.len = CCC_DATA_LEN;
+        CyBle_GattsWriteAttributeValue(&StreamNotificationCCCDHandle, 0x00, &ConnectionHandle, CYBLE_GATT_DB_LOCALLY_INITIATED);
     }
 	
 }
 
 
+/*************************************************************************************************************************
+* Function Name: UpdateCalibrationAttribute
+**************************************************************************************************************************
+* Summary: This function writes the full-tank scaling status to the calibration characteristic
+* so that it can be read by the Central device.
+*
+* Parameters:
+*  CalibrationStatus - Full-tank scaling state
+*
+* Return:
+*  void
+*
+*************************************************************************************************************************/
+void UpdateCalibrationAttribute(uint8 CalibrationStatus)
+{
+    CalibrationHandle.attrHandle = CALIBRATION_CHAR_HANDLE;
+    CalibrationHandle.value.val = &CalibrationStatus;
+    CalibrationHandle.value.len = CALIBRATION_CHAR_DATA_LEN;
+    
+    CyBle_GattsWriteAttributeValue(&CalibrationHandle, 0x00, &ConnectionHandle, CYBLE_GATT_DB_LOCALLY_INITIATED);
+}
+
+
+/*************************************************************************************************************************
+* Function Name: UpdateEstimatorAttribute
+**************************************************************************************************************************
+* Summary: This function writes the predicted time to empty and the consumption rate to the
+* estimator characteristic so that the Central device can read them right after connecting
+* instead of polling the level.
+*
+* Parameters:
+*  TimeToEmpty - Predicted minutes until the tank is empty, 0xFFFF if unknown
+*  ConsumptionRate - Level drop in percent per hour, fixed precision 8.8
+*
+* Return:
+*  void
+*
+*************************************************************************************************************************/
+void UpdateEstimatorAttribute(uint16 TimeToEmpty, uint16 ConsumptionRate)
+{
+    uint8 EstimatorData[ESTIMATOR_CHAR_DATA_LEN];
+    
+    /* Little endian, as all BLE attribute values */
+    EstimatorData[0] = LO8(TimeToEmpty);
+    EstimatorData[1] = HI8(TimeToEmpty);
+    EstimatorData[2] = LO8(ConsumptionRate);
+    EstimatorData[3] = HI8(ConsumptionRate);
+    
+    EstimatorHandle.attrHandle = ESTIMATOR_CHAR_HANDLE;
+    EstimatorHandle.value.val = EstimatorData;
+    EstimatorHandle.value.len = ESTIMATOR_CHAR_DATA_LEN;
+    
+    CyBle_GattsWriteAttributeValue(&EstimatorHandle, 0x00, &ConnectionHandle, CYBLE_GATT_DB_LOCALLY_INITIATED);
+}
+
+
+/*************************************************************************************************************************
+* Function Name: UpdateDiagnosticsAttribute
+**************************************************************************************************************************
+* Summary: This function writes the state residency record to the diagnostics characteristic.
+* The record layout is given by the POWER_DIAG offsets in power.h.
+*
+* Parameters:
+*  DiagnosticsData - DIAGNOSTICS_CHAR_DATA_LEN bytes packed by PowerDiagnosticsPack
+*
+* Return:
+*  void
+*
+*************************************************************************************************************************/
+void UpdateDiagnosticsAttribute(uint8 *DiagnosticsData)
+{
+    DiagnosticsHandle.attrHandle = DIAGNOSTICS_CHAR_HANDLE;
+    DiagnosticsHandle.value.val = DiagnosticsData;
+    DiagnosticsHandle.value.len = DIAGNOSTICS_CHAR_DATA_LEN;
+    
+    CyBle_GattsWriteAttributeValue(&DiagnosticsHandle, 0x00, &ConnectionHandle, CYBLE_GATT_DB_LOCALLY_INITIATED);
+}
+
+
 /*************************************************************************************************************************
 * Function Name: UpdateConnectionParameters
 **************************************************************************************************************************
-* Summary: This function sends the Connection Parameters Update Request to the Central device
-* immediately after connected and modifies the connection interval for low power operation.
-* The Central device can accept or reject this request based on the Central device configuration.
+* Summary: This function asks the Central device for short connection intervals while there was
+* activity in the last CONN_IDLE_TIMEOUT_MS, and for long intervals with slave latency when idle.
+* A request is only sent when the wanted profile is not the accepted one and no request is
+* waiting for a response. A profile the Central device rejected, or a request it did not answer,
+* is sent again after CONN_PARAM_RETRY_MS.
 *
 * Parameters:
 *  void
@@ -241,11 +706,214 @@ void UpdateNotificationCCCDAttribute(void)
 *************************************************************************************************************************/
 void UpdateConnectionParameters(void)
 {
-    if(DeviceConnected && ConnectionParametersUpdateRequired)
+    uint8 Profile;
+    
+    if(!DeviceConnected)
+    {
+        return;
+    }
+    
+    Profile = ((systemTimeMs - ConnLastActivityMs) < CONN_IDLE_TIMEOUT_MS) ? CONN_PROFILE_ACTIVE : CONN_PROFILE_IDLE;
+    
+    if((ConnParamRequested != CONN_PROFILE_NONE) && ((systemTimeMs - ConnParamRequestMs) < CONN_PARAM_RETRY_MS))
+    {
+        return;
+    }
+    ConnParamRequested = CONN_PROFILE_NONE;
+    
+    if((Profile == ConnParamProfile) ||
+        ((Profile == ConnParamRejected) && ((systemTimeMs - ConnParamRejectMs) < CONN_PARAM_RETRY_MS)))
+    {
+        return;
+    }
+    
+    ConnectionParametersHandle = ConnParamProfiles[Profile];
+    
+    /* Send Connection Parameter Update request with desired parameter values */
+    if(CyBle_L2capLeConnectionParamUpdateRequest(ConnectionHandle.bdHandle, &ConnectionParametersHandle) == CYBLE_ERROR_OK)
+    {
+        ConnParamRequested = Profile;
+        ConnParamRequestMs = systemTimeMs;
+        ConnParamRequestCount++;
+    }
+}
+
+
+/*************************************************************************************************************************
+* Function Name: ConnectionMarkActivity
+**************************************************************************************************************************
+* Summary: Called when a level notification or history transfer is sent. Keeps the short
+* connection intervals, or asks for them right away when the connection is idle.
+*
+* Parameters:
+*  void
+*
+* Return:
+*  void
+*
+*************************************************************************************************************************/
+void ConnectionMarkActivity(void)
+{
+    ConnLastActivityMs = systemTimeMs;
+    
+    if(DeviceConnected && (ConnParamProfile != CONN_PROFILE_ACTIVE) && (ConnParamRequested == CONN_PROFILE_NONE))
+    {
+        SchedulerStart(SCHEDULER_TASK_CONN, 0u, CONN_PARAM_CHECK_PERIOD_MS);
+    }
+}
+
+
+/*************************************************************************************************************************
+* Function Name: HandleConnectionUpdate
+**************************************************************************************************************************
+* Summary: Scheduler task that runs every CONN_PARAM_CHECK_PERIOD_MS while connected, and right
+* away after a connection, a CCCD write or new activity. It sends a Connection Parameters Update
+* Request when the activity changed and updates the CCCD attribute.
+*
+* Parameters:
+*  void
+*
+* Return:
+*  void
+*
+*************************************************************************************************************************/
+void HandleConnectionUpdate(void)
+{
+    UpdateConnectionParameters();
+    UpdateNotificationCCCDAttribute();
+}
+
+
+/*************************************************************************************************************************
+* Function Name: UpdateLevelNotification
+**************************************************************************************************************************
+* Summary: Notification policy, called in BLE_PROCESS after every frame. A level that moved by
+* notifyDeadband or more since the last notification, or a change of the level flags, schedules
+* the notification task, right away when notifyMinIntervalMs has passed since the last
+* notification, else when it has. Changes while a notification is pending are coalesced, the
+* task sends the latest level. Smaller changes are not notified, so a flickering LSB does not
+* keep the radio busy.
+*
+* Parameters:
+*  void
+*
+* Return:
+*  void
+*
+*************************************************************************************************************************/
+void UpdateLevelNotification(void)
+{
+    int32 Delta = levelPercent - previousLevelPercent;
+    uint32 Elapsed;
+    
+    if(!DeviceConnected || !(CapSenseNotificationEnabled || LevelNotificationEnabled))
+    {
+        return;
+    }
+    if((Delta < notifyDeadband) && (Delta > -notifyDeadband) && (LevelFlags() == NotifyFlags))
+    {
+        return;
+    }
+    if(NotifyPending)
     {
-        ConnectionParametersUpdateRequired = FALSE; //Clear the Connection Parameters Update flag
-        /* Send Connection Parameter Update request with desired parameter values */
-        CyBle_L2capLeConnectionParamUpdateRequest(ConnectionHandle.bdHandle, &ConnectionParametersHandle);
+        notifyCoalescedCount++;
+        return;
+    }
+    
+    NotifyPending = TRUE;
+    Elapsed = systemTimeMs - NotifyLastMs;
+    SchedulerStart(SCHEDULER_TASK_NOTIFY, (Elapsed >= notifyMinIntervalMs) ? 0u : (notifyMinIntervalMs - Elapsed), notifyHeartbeatMs);
+}
+
+
+/*************************************************************************************************************************
+* Function Name: HandleNotification
+**************************************************************************************************************************
+* Summary: Scheduler task scheduled by UpdateLevelNotification for a level change, and every
+* notifyHeartbeatMs after the last notification while connected. It notifies the latest level
+* on the CapSense and on the packed level characteristic, where notifications are enabled. The
+* heartbeat gives the app a fresh level at a predictable rate when the level is steady.
+*
+* Parameters:
+*  void
+*
+* Return:
+*  void
+*
+*************************************************************************************************************************/
+void HandleNotification(void)
+{
+    if(DeviceConnected && (CapSenseNotificationEnabled || LevelNotificationEnabled))
+    {
+        if(CapSenseNotificationEnabled)
+        {
+            SendCapSenseNotification(levelPercent >> 8);
+        }
+        if(LevelNotificationEnabled)
+        {
+            SendLevelNotification();
+        }
+        
+        if(NotifyPending)
+        {
+            notifySentCount++;
+            ConnectionMarkActivity();
+        }
+        else
+        {
+            notifyHeartbeatCount++;
+        }
+        previousLevelPercent = levelPercent;
+        NotifyFlags = LevelFlags();
+        NotifyLastMs = systemTimeMs;
+    }
+    NotifyPending = FALSE;
+}
+
+
+/*************************************************************************************************************************
+* Function Name: HandleHistorySync
+**************************************************************************************************************************
+* Summary: Scheduler task that runs every HISTORY_SYNC_PERIOD_MS after the Central device enabled
+* the history notifications. It sends the samples recorded while disconnected, as many per
+* notification as the negotiated MTU allows, until only NOTIFY_QUEUE_RESERVED entries of the
+* notification queue are free, and continues at the next run. The reserved entries keep room for
+* the level notifications. HistoryAcknowledge marks the samples as sent when the stack accepts
+* them, and has them packed again when they are dropped. A notification without samples, once
+* every queued sample was accepted, ends the transfer and stops the task.
+*
+* Parameters:
+*  void
+*
+* Return:
+*  void
+*
+*************************************************************************************************************************/
+void HandleHistorySync(void)
+{
+    uint8 HistoryData[MTU_XCHANGE_DATA_LEN - NOTIFICATION_HEADER_LEN];
+    uint16 Length;
+    
+    while(DeviceConnected && HistoryNotificationEnabled && (NotifyQueueSpace() > NOTIFY_QUEUE_RESERVED))
+    {
+        Length = HistoryPack(HistoryData, NegotiatedMtu - NOTIFICATION_HEADER_LEN);
+        if((Length == HISTORY_NTF_SAMPLES) && HistoryPending())
+        {
+            break; //Queued samples may still be dropped and packed again
+        }
+        
+        if(!NotifyQueuePut(HISTORY_CHAR_HANDLE, HistoryData, Length, FALSE, NULL, HistoryAcknowledge))
+        {
+            break;
+        }
+        HistoryQueue();
+        ConnectionMarkActivity();
+        
+        if(Length == HISTORY_NTF_SAMPLES)
+        {
+            SchedulerStop(SCHEDULER_TASK_SYNC);
+            break;
+        }
     }
 }
 /***********************************************************************************************************************/
@@ -50,22 +50,61 @@
 /*****************************************************************************
 * Macros 
 *****************************************************************************/
-#define CONN_PARAM_UPDATE_MIN_CONN_INTERVAL 0x64 //Minimum connection interval
-#define CONN_PARAM_UPDATE_MAX_CONN_INTERVAL 0x6E //Maximum connection interval
-#define CONN_PARAM_UPDATE_SLAVE_LATENCY 0x00 //Slave latency
-#define CONN_PARAM_UPDATE_SUPRV_TIMEOUT 0xC8 //Supervision timeout
+/* Connection parameters requested while history is transferred or the level changes.
+*  Intervals in 1.25 ms, supervision timeout in 10 ms */
+#define CONN_PARAM_ACTIVE_MIN_CONN_INTERVAL 0x000C //Minimum connection interval, 15 ms
+#define CONN_PARAM_ACTIVE_MAX_CONN_INTERVAL 0x0018 //Maximum connection interval, 30 ms
+#define CONN_PARAM_ACTIVE_SLAVE_LATENCY 0x0000 //Slave latency
+#define CONN_PARAM_ACTIVE_SUPRV_TIMEOUT 0x00C8 //Supervision timeout, 2 s
+/* Connection parameters requested when idle. The radio wakes every 2 s at most */
+#define CONN_PARAM_IDLE_MIN_CONN_INTERVAL 0x0140 //Minimum connection interval, 400 ms
+#define CONN_PARAM_IDLE_MAX_CONN_INTERVAL 0x0190 //Maximum connection interval, 500 ms
+#define CONN_PARAM_IDLE_SLAVE_LATENCY 0x0003 //Slave latency, connection events the device may skip
+#define CONN_PARAM_IDLE_SUPRV_TIMEOUT 0x0258 //Supervision timeout, 6 s
+
+/* Connection parameter profiles */
+#define CONN_PROFILE_ACTIVE				(0u)
+#define CONN_PROFILE_IDLE				(1u)
+#define CONN_PROFILE_COUNT				(2u)
+#define CONN_PROFILE_NONE				(0xFFu) //No profile accepted yet, or the Central device chose the parameters
+
+#define CONN_PARAM_ACCEPTED				(0u) //Result of CYBLE_EVT_L2CAP_CONN_PARAM_UPDATE_RSP when the Central device accepted
 #define CAPSENSE_SERVICE_INDEX          (0x00)
 
 
+/* Characteristics of the CapSense service, in the order of the BLE component customizer */
 #define CAPSENSE_SLIDER_CHAR_INDEX      (0x00)
 #define RGB_LED_CHAR_INDEX              (0x00)
-#define CAPSENSE_SLIDER_CHAR_HANDLE		(0x000E)
-
-
-#define CAPSENSE_CCC_HANDLE				(0x000F)
+#define CALIBRATION_CHAR_INDEX          (0x01)
+#define ESTIMATOR_CHAR_INDEX            (0x02)
+#define DIAGNOSTICS_CHAR_INDEX          (0x03)
+#define LEVEL_CHAR_INDEX                (0x04)
+#define HISTORY_CHAR_INDEX              (0x05)
+#define STREAM_CHAR_INDEX               (0x06)
+#define CCC_DESC_INDEX                  (0x00) //The Client Characteristic Configuration is the first descriptor of the notified characteristics
+
+/* Attribute handles generated by the BLE component */
+#define CUSTOM_CHAR_HANDLE(index)		(cyBle_customs[CAPSENSE_SERVICE_INDEX].customServiceInfo[(index)].customServiceCharHandle)
+#define CUSTOM_CCC_HANDLE(index)		(cyBle_customs[CAPSENSE_SERVICE_INDEX].customServiceInfo[(index)].customServiceCharDescriptors[CCC_DESC_INDEX])
+#define CAPSENSE_SLIDER_CHAR_HANDLE		CUSTOM_CHAR_HANDLE(CAPSENSE_SLIDER_CHAR_INDEX)
+#define CAPSENSE_CCC_HANDLE				CUSTOM_CCC_HANDLE(CAPSENSE_SLIDER_CHAR_INDEX)
+#define CALIBRATION_CHAR_HANDLE			CUSTOM_CHAR_HANDLE(CALIBRATION_CHAR_INDEX)
+#define ESTIMATOR_CHAR_HANDLE			CUSTOM_CHAR_HANDLE(ESTIMATOR_CHAR_INDEX)
+#define DIAGNOSTICS_CHAR_HANDLE			CUSTOM_CHAR_HANDLE(DIAGNOSTICS_CHAR_INDEX)
+#define LEVEL_CHAR_HANDLE				CUSTOM_CHAR_HANDLE(LEVEL_CHAR_INDEX)
+#define LEVEL_CCC_HANDLE				CUSTOM_CCC_HANDLE(LEVEL_CHAR_INDEX)
+#define HISTORY_CHAR_HANDLE				CUSTOM_CHAR_HANDLE(HISTORY_CHAR_INDEX)
+#define HISTORY_CCC_HANDLE				CUSTOM_CCC_HANDLE(HISTORY_CHAR_INDEX)
+#define STREAM_CHAR_HANDLE				CUSTOM_CHAR_HANDLE(STREAM_CHAR_INDEX)
+#define STREAM_CCC_HANDLE				CUSTOM_CCC_HANDLE(STREAM_CHAR_INDEX)
 
 #define CCC_DATA_LEN					(2)
 #define CAPSENSE_CHAR_DATA_LEN			(1)
+#define CALIBRATION_CHAR_DATA_LEN		(1)
+#define ESTIMATOR_CHAR_DATA_LEN			(4)
+#define DIAGNOSTICS_CHAR_DATA_LEN		(POWER_DIAG_LEN) //Read with Read Blob
+#define LEVEL_CHAR_DATA_LEN				(LEVEL_NTF_LEN)
+#define STREAM_WRITE_DATA_LEN			(1) //STREAM_FIELD_ bits written to the stream characteristic, the notifications are longer
 
 
 #define CAPSENSE_SLIDER_CCC_INDEX		(0u)
@@ -80,7 +119,46 @@
 #define LED_ADV_BLINK_PERIOD			(40000)
 #define LED_CONN_ON_PERIOD				(145000)
 
-#define MTU_XCHANGE_DATA_LEN			(0x0020)
+#define MTU_XCHANGE_DATA_LEN			(CYBLE_GATT_MTU) //MTU of the BLE component, set to 136 in its GAP settings for one flash row of history per notification
+#define DEFAULT_MTU_LEN					(0x0017) //ATT MTU until the Central device exchanges the MTU
+#define NOTIFICATION_HEADER_LEN			(3) //Opcode and handle of a notification
+
+/* Level notification policy defaults, changed at run time through the notify globals */
+#define NOTIFICATION_INTERVAL_MS		(320u) //Minimum time between two level notifications
+#define NOTIFICATION_DEADBAND			(0x0040) //Level change in percent that is notified, 0.25 percent in fixed precision 24.8
+#define NOTIFICATION_HEARTBEAT_MS		(30000u) //Longest time without a level notification
+#define CONN_UPDATE_DELAY_MS			(0u) //Time from connection to the connection parameters update
+#define CONN_PARAM_CHECK_PERIOD_MS		(1000u) //Period of the connection parameter check while connected
+#define CONN_IDLE_TIMEOUT_MS			(5000u) //Time without activity before the idle parameters are requested
+#define CONN_PARAM_RETRY_MS				(30000u) //Time before a rejected or unanswered request is sent again
+#define HISTORY_SYNC_PERIOD_MS			(50u) //Retry period of the history transfer while the stack buffers are full
+
+#define CALIBRATION_CMD_FULL_SCALE		(0x01) //Calibration command to start full-tank scaling
+
+/* Packed level notification, little endian. Fits the 20 bytes of the default ATT MTU */
+#define LEVEL_NTF_SEQUENCE				(0u) //uint8 incremented with every notification handed to the stack, gaps show lost notifications. A replaced level takes no number
+#define LEVEL_NTF_LEVEL_MM				(1u) //int32 levelMm, fixed precision 24.8
+#define LEVEL_NTF_PERCENT				(5u) //uint16 levelPercent, fixed precision 8.8
+#define LEVEL_NTF_ACTIVE_COUNT			(7u) //uint8 sensorActiveCount, in half sensors
+#define LEVEL_NTF_FLAGS					(8u) //uint8 LEVEL_NTF_FLAG_ bits
+#define LEVEL_NTF_BATTERY				(9u) //uint8 battery level in percent, POWER_BATTERY_UNKNOWN if not measured
+#define LEVEL_NTF_TIMESTAMP				(10u) //uint32 systemTimeMs of the frame
+#define LEVEL_NTF_LEN					(14u)
+
+#define LEVEL_NTF_FLAG_SLOSHING			(0x01u) //Level held because the liquid sloshes
+#define LEVEL_NTF_FLAG_FULL_SCALE		(0x02u) //Full-tank scaling in progress
+
+/* Level broadcast in the manufacturer specific data of the advertising packet, appended to the
+*  advertising data of the BLE component. Little endian */
+#define ADV_TYPE_MANUFACTURER_DATA		(0xFFu)
+#define BROADCAST_COMPANY_ID			(0xFFFFu) //Reserved for tests by the Bluetooth SIG, replace with the assigned company ID
+#define BROADCAST_COMPANY				(0u) //uint16 company ID
+#define BROADCAST_PERCENT				(2u) //uint16 levelPercent, fixed precision 8.8
+#define BROADCAST_FLAGS					(4u) //uint8 LEVEL_NTF_FLAG_ bits
+#define BROADCAST_BATTERY				(5u) //uint8 battery level in percent, POWER_BATTERY_UNKNOWN if not measured
+#define BROADCAST_COUNTER				(6u) //uint8 incremented with every change, scanners skip repeated packets
+#define BROADCAST_DATA_LEN				(7u)
+#define BROADCAST_AD_LEN				(BROADCAST_DATA_LEN + 2u) //With the AD length and type bytes
 
 
 /*****************************************************************************
@@ -96,8 +174,18 @@ extern uint8 sendCapSenseSliderNotifications;
 void CustomEventHandler(uint32 event, void * eventParam);
 void UpdateNotificationCCCDAttribute(void);
 void UpdateConnectionParameters(void);
+void HandleConnectionUpdate(void);
+void ConnectionMarkActivity(void);
+void HandleNotification(void);
+void UpdateLevelNotification(void);
+void HandleHistorySync(void);
 
 void SendCapSenseNotification(uint8 CapSenseSliderData);
+void SendLevelNotification(void);
+void UpdateBroadcastData(void);
+void UpdateCalibrationAttribute(uint8 CalibrationStatus);
+void UpdateEstimatorAttribute(uint16 TimeToEmpty, uint16 ConsumptionRate);
+void UpdateDiagnosticsAttribute(uint8 *DiagnosticsData);
 
 
 #endif  /* #if !defined(_BLE_APPLICATIONS_H) */
@@ -0,0 +1,228 @@
+/*****************************************************************************
+* File Name: calibration.c
+*
+* Version: 1.00
+*
+* Description: Run-time calibration of the CapSense liquid level sensors.
+*
+* Related Document: Code example CE202479
+*
+* Hardware Dependency: See code example CE202479
+*
+******************************************************************************
+* Copyright (2015), Cypress Semiconductor Corporation.
+******************************************************************************
+* This software is owned by Cypress Semiconductor Corporation (Cypress) and is
+* protected by and subject to worldwide patent protection (United States and
+* foreign), United States copyright laws and international treaty provisions.
+* Cypress hereby grants to licensee a personal, non-exclusive, non-transferable
+* license to copy, use, modify, create derivative works of, and compile the
+* Cypress Source Code and derivative works for the sole purpose of creating
+* custom software in support of licensee product to be used only in conjunction
+* with a Cypress integrated circuit as specified in the applicable agreement.
+* Any reproduction, modification, translation, compilation, or representation of
+* this software except as specified above is prohibited without the express
+* written permission of Cypress.
+*
+* Disclaimer: CYPRESS MAKES NO WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, WITH
+* REGARD TO THIS MATERIAL, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+* Cypress reserves the right to make changes without further notice to the
+* materials described herein. Cypress does not assume any liability arising out
+* of the application or use of any product or circuit described herein. Cypress
+* does not authorize its products for use as critical components in life-support
+* systems where a malfunction or failure may reasonably be expected to result in
+* significant injury to the user. The inclusion of Cypress' product in a life-
+* support systems application implies that the manufacturer assumes all risk of
+* such use and in doing so indemnifies Cypress against all charges. Use may be
+* limited by and subject to the applicable Cypress software license agreement.
+*****************************************************************************/
+#include <project.h>
+#include <main.h>
+#include <calibration.h>
+
+
+/* Global variables */
+/* Global variables used because this is the method uProbe uses to access firmware data */
+uint8 baselineDryCount[NUMSENSORS] = {0u}; /* Consecutive frames each sensor was confirmed dry */
+int16 baselineSaved[NUMSENSORS] = {0u};    /* Empty offsets currently stored in flash */
+uint32 baselineSaveCount = 0u;             /* Number of flash writes of the empty offsets */
+uint8 calScaleState = CAL_SCALE_IDLE;      /* State of the full-tank scaling */
+/* External globals */
+extern int16 sensorEmptyOffset[];
+extern const int16 CYCODE eepromEmptyOffset[];
+extern int16 sensorScale[];
+extern const int16 CYCODE eepromScale[];
+extern uint16 sensorFiltered[];
+extern int16 sensorDiff[];
+extern int16 sensorProcessed[];
+extern uint16 sensorLimit;
+extern uint8 motionSloshing;
+extern uint8 DeviceConnected;
+
+/* Static variables */
+static int32 baselineFilter[NUMSENSORS];   /* Tracked empty offsets. Scaled by 2^BASELINE_SHIFT */
+static uint32 baselineSaveTimer = 0u;      /* Frames since the last flash write */
+static int32 calScaleSum[NUMSENSORS];      /* Sum of full-tank difference counts */
+static uint8 calScaleFrames = 0u;          /* Full-tank frames summed so far */
+
+
+/*******************************************************************************
+* Function Name: CalibrationInit
+********************************************************************************/
+/* Start baseline tracking from the empty offsets loaded from flash. */
+void CalibrationInit(void)
+{
+    uint8 i;
+    
+    for(i = 0; i < NUMSENSORS; i++)
+    {
+        baselineSaved[i] = eepromEmptyOffset[i];
+        baselineFilter[i] = (int32)sensorEmptyOffset[i] << BASELINE_SHIFT;
+        baselineDryCount[i] = 0u;
+    }
+}
+
+/*******************************************************************************
+* Function Name: CalibrationTrackBaseline
+********************************************************************************/
+/* Learn the empty offset of sensors that are confirmed dry.                              */
+/* A sensor is dry when it is at least two sensors above the highest submerged sensor,     */
+/* so the partially covered boundary sensor is never used, and its processed count has    */
+/* stayed below BASELINE_DRY_LIMIT for BASELINE_DRY_FRAMES frames with the liquid still.   */
+/* The offsets are written to flash only when one has moved by BASELINE_SAVE_DELTA, at     */
+/* most once per BASELINE_SAVE_INTERVAL frames and never while a Central is connected.    */
+void CalibrationTrackBaseline(void)
+{
+    uint8 i;
+    int8 top = -1;          /* Highest submerged sensor */
+    int16 delta;
+    uint8 saveRequired = FALSE;
+    
+    for(i = 0; i < NUMSENSORS; i++)
+    {
+        if(sensorProcessed[i] > (int32)sensorLimit)
+        {
+            top = (int8)i;
+        }
+    }
+    
+    for(i = 0; i < NUMSENSORS; i++)
+    {
+        if(motionSloshing || ((int8)i <= (top + 1)) || (sensorProcessed[i] >= BASELINE_DRY_LIMIT))
+        {
+            baselineDryCount[i] = 0u;
+            continue;
+        }
+        
+        if(baselineDryCount[i] < BASELINE_DRY_FRAMES)
+        {
+            baselineDryCount[i]++;
+            continue;
+        }
+        
+        baselineFilter[i] += (int32)sensorFiltered[i] - (baselineFilter[i] >> BASELINE_SHIFT);
+        sensorEmptyOffset[i] = (int16)(baselineFilter[i] >> BASELINE_SHIFT);
+        
+        delta = sensorEmptyOffset[i] - baselineSaved[i];
+        if((delta > BASELINE_SAVE_DELTA) || (delta < -BASELINE_SAVE_DELTA))
+        {
+            saveRequired = TRUE;
+        }
+    }
+    
+    if(baselineSaveTimer < BASELINE_SAVE_INTERVAL)
+    {
+        baselineSaveTimer++;
+    }
+    else if(saveRequired && !DeviceConnected)
+    {
+        if(Em_EEPROM_Write((const uint8 *)sensorEmptyOffset, (const uint8 *)eepromEmptyOffset, NUMSENSORS * sizeof(int16)) == CYRET_SUCCESS)
+        {
+            for(i = 0; i < NUMSENSORS; i++)
+            {
+                baselineSaved[i] = sensorEmptyOffset[i];
+            }
+            baselineSaveCount++;
+        }
+        baselineSaveTimer = 0u;
+    }
+}
+
+/*******************************************************************************
+* Function Name: CalibrationStartFullScale
+********************************************************************************/
+/* Start full-tank scaling. The tank must be full when this is called. */
+void CalibrationStartFullScale(void)
+{
+    uint8 i;
+    
+    for(i = 0; i < NUMSENSORS; i++)
+    {
+        calScaleSum[i] = 0;
+    }
+    calScaleFrames = 0u;
+    calScaleState = CAL_SCALE_RUNNING;
+    UpdateCalibrationAttribute(calScaleState);
+}
+
+/*******************************************************************************
+* Function Name: CalibrationProcessFullScale
+********************************************************************************/
+/* Average the difference counts of 2^CAL_SCALE_FRAMES_SHIFT full-tank frames and set    */
+/* the scale of each sensor so its full-tank count becomes SENSORMAX.                     */
+/* Scaling fails, and the scales are left unchanged, if any sensor is not submerged or   */
+/* needs a scale outside CAL_SCALE_MIN..CAL_SCALE_MAX. New scales are written to flash.  */
+void CalibrationProcessFullScale(void)
+{
+    uint8 i;
+    int32 average;
+    int32 scale[NUMSENSORS];
+    
+    if(calScaleState != CAL_SCALE_RUNNING)
+    {
+        return;
+    }
+    
+    for(i = 0; i < NUMSENSORS; i++)
+    {
+        calScaleSum[i] += sensorDiff[i];
+    }
+    if(++calScaleFrames < (1u << CAL_SCALE_FRAMES_SHIFT))
+    {
+        return;
+    }
+    
+    calScaleState = CAL_SCALE_DONE;
+    for(i = 0; i < NUMSENSORS; i++)
+    {
+        average = calScaleSum[i] >> CAL_SCALE_FRAMES_SHIFT;
+        if(average < (int32)CAL_SCALE_MIN_DIFF)
+        {
+            calScaleState = CAL_SCALE_FAILED;
+            break;
+        }
+        /* Scale in fixed precision 8.8, rounded */
+        scale[i] = (((int32)SENSORMAX << 8) + (average >> 1)) / average;
+        if((scale[i] < CAL_SCALE_MIN) || (scale[i] > CAL_SCALE_MAX))
+        {
+            calScaleState = CAL_SCALE_FAILED;
+            break;
+        }
+    }
+    
+    if(calScaleState == CAL_SCALE_DONE)
+    {
+        for(i = 0; i < NUMSENSORS; i++)
+        {
+            sensorScale[i] = (int16)scale[i];
+        }
+        if(Em_EEPROM_Write((const uint8 *)sensorScale, (const uint8 *)eepromScale, NUMSENSORS * sizeof(int16)) != CYRET_SUCCESS)
+        {
+            calScaleState = CAL_SCALE_FAILED;
+        }
+    }
+    UpdateCalibrationAttribute(calScaleState);
+}
+
+/* [] END OF FILE */
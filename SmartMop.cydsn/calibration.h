@@ -0,0 +1,74 @@
+/*****************************************************************************
+* File Name: calibration.h
+*
+* Version: 1.00
+*
+* Description: Run-time calibration of the CapSense liquid level sensors.
+*
+* Related Document: Code example CE202479
+*
+* Hardware Dependency: See code example CE202479
+*
+******************************************************************************
+* Copyright (2015), Cypress Semiconductor Corporation.
+******************************************************************************
+* This software is owned by Cypress Semiconductor Corporation (Cypress) and is
+* protected by and subject to worldwide patent protection (United States and
+* foreign), United States copyright laws and international treaty provisions.
+* Cypress hereby grants to licensee a personal, non-exclusive, non-transferable
+* license to copy, use, modify, create derivative works of, and compile the
+* Cypress Source Code and derivative works for the sole purpose of creating
+* custom software in support of licensee product to be used only in conjunction
+* with a Cypress integrated circuit as specified in the applicable agreement.
+* Any reproduction, modification, translation, compilation, or representation of
+* this software except as specified above is prohibited without the express
+* written permission of Cypress.
+*
+* Disclaimer: CYPRESS MAKES NO WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, WITH
+* REGARD TO THIS MATERIAL, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+* Cypress reserves the right to make changes without further notice to the
+* materials described herein. Cypress does not assume any liability arising out
+* of the application or use of any product or circuit described herein. Cypress
+* does not authorize its products for use as critical components in life-support
+* systems where a malfunction or failure may reasonably be expected to result in
+* significant injury to the user. The inclusion of Cypress' product in a life-
+* support systems application implies that the manufacturer assumes all risk of
+* such use and in doing so indemnifies Cypress against all charges. Use may be
+* limited by and subject to the applicable Cypress software license agreement.
+*****************************************************************************/
+#if !defined(_CALIBRATION_H)
+#define _CALIBRATION_H
+    
+#include <project.h>
+#include <main.h>
+
+
+/* Function prototypes */
+void CalibrationInit(void);
+void CalibrationTrackBaseline(void);
+void CalibrationStartFullScale(void);
+void CalibrationProcessFullScale(void);
+
+/* Project Constants */
+/* Baseline tracking constants */
+#define BASELINE_DRY_LIMIT          ((int16)(SENSORMAX / 8)) /* Processed counts below this on a sensor above the boundary are dry */
+#define BASELINE_DRY_FRAMES         (200u)          /* Consecutive dry frames before a sensor's baseline is tracked */
+#define BASELINE_SHIFT              (8u)            /* Baseline filter weight 1/256 per frame */
+#define BASELINE_SAVE_DELTA         (16)            /* Change in counts of any baseline that is worth a flash write */
+#define BASELINE_SAVE_INTERVAL      (30000u)        /* Minimum frames between flash writes (5 minutes in fast scan mode) */
+
+/* Full-tank scaling constants */
+#define CAL_SCALE_FRAMES_SHIFT      (5u)            /* Full-tank frames averaged for scaling is 2^CAL_SCALE_FRAMES_SHIFT */
+#define CAL_SCALE_MIN_DIFF          (SENSORMAX / 4) /* A sensor with fewer full-tank counts is not submerged */
+#define CAL_SCALE_MIN               (0x0080)        /* Smallest accepted scale, 0.5 in fixed precision 8.8 */
+#define CAL_SCALE_MAX               (0x0400)        /* Largest accepted scale, 4.0 in fixed precision 8.8 */
+/* Full-tank scaling states */
+#define CAL_SCALE_IDLE              (0x00u)
+#define CAL_SCALE_RUNNING           (0x01u)
+#define CAL_SCALE_DONE              (0x02u)
+#define CAL_SCALE_FAILED            (0x03u)
+
+#endif /* _CALIBRATION_H */
+
+/* [] END OF FILE */
@@ -10,6 +10,7 @@
 #include <I2C_I2C.h>
 #include "common_bmi270.h"
 #include "bmi2_defs.h"
+#include "profile.h"
 
 /******************************************************************************/
 /*!                 Macro definitions                                         */
@@ -35,6 +36,7 @@ BMI2_INTF_RETURN_TYPE bmi2_i2c_read(uint8_t reg_addr, uint8_t *reg_data, uint32_
     uint8_t dev_addr = *(uint8_t*)intf_ptr;
     uint8_t I2CWriteBuffer[0x01] = {reg_addr}; //Location from which the calibration data is to be read
     
+    PROFILE_BEGIN(PROFILE_PROBE_BMI2_REGS);
     I2C_I2CMasterWriteBuf(dev_addr, I2CWriteBuffer, sizeof(I2CWriteBuffer), I2C_I2C_MODE_COMPLETE_XFER);
     while(!(I2C_I2CMasterStatus() & I2C_I2C_MSTAT_WR_CMPLT)); //Wait till the master completes writing
     I2C_I2CMasterClearStatus(); //Clear I2C master status
@@ -42,6 +44,7 @@ BMI2_INTF_RETURN_TYPE bmi2_i2c_read(uint8_t reg_addr, uint8_t *reg_data, uint32_
     int result = I2C_I2CMasterReadBuf(dev_addr, reg_data, len, I2C_I2C_MODE_COMPLETE_XFER);
     while(!(I2C_I2CMasterStatus() & I2C_I2C_MSTAT_RD_CMPLT)); //Wait till the master completes reading
     I2C_I2CMasterClearStatus(); //Clear I2C master status
+    PROFILE_END(PROFILE_PROBE_BMI2_REGS);
 
     return result;
     
@@ -0,0 +1,158 @@
+/*****************************************************************************
+* File Name: estimator.c
+*
+* Version: 1.00
+*
+* Description: Liquid consumption rate and time-to-empty estimation.
+*
+* Related Document: Code example CE202479
+*
+* Hardware Dependency: See code example CE202479
+*
+******************************************************************************
+* Copyright (2015), Cypress Semiconductor Corporation.
+******************************************************************************
+* This software is owned by Cypress Semiconductor Corporation (Cypress) and is
+* protected by and subject to worldwide patent protection (United States and
+* foreign), United States copyright laws and international treaty provisions.
+* Cypress hereby grants to licensee a personal, non-exclusive, non-transferable
+* license to copy, use, modify, create derivative works of, and compile the
+* Cypress Source Code and derivative works for the sole purpose of creating
+* custom software in support of licensee product to be used only in conjunction
+* with a Cypress integrated circuit as specified in the applicable agreement.
+* Any reproduction, modification, translation, compilation, or representation of
+* this software except as specified above is prohibited without the express
+* written permission of Cypress.
+*
+* Disclaimer: CYPRESS MAKES NO WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, WITH
+* REGARD TO THIS MATERIAL, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+* Cypress reserves the right to make changes without further notice to the
+* materials described herein. Cypress does not assume any liability arising out
+* of the application or use of any product or circuit described herein. Cypress
+* does not authorize its products for use as critical components in life-support
+* systems where a malfunction or failure may reasonably be expected to result in
+* significant injury to the user. The inclusion of Cypress' product in a life-
+* support systems application implies that the manufacturer assumes all risk of
+* such use and in doing so indemnifies Cypress against all charges. Use may be
+* limited by and subject to the applicable Cypress software license agreement.
+*****************************************************************************/
+#include <project.h>
+#include <main.h>
+#include <estimator.h>
+
+
+/* Global variables */
+/* Global variables used because this is the method uProbe uses to access firmware data */
+uint16 consumptionRate = 0u;                /* Level drop in percent per hour. Fixed precision 8.8 */
+uint16 timeToEmpty = ESTIMATOR_UNKNOWN;     /* Predicted minutes until the tank is empty */
+/* External globals */
+extern int32 levelPercent;
+
+/* Static variables */
+static int32 estimatorLevel[ESTIMATOR_WINDOW]; /* Sliding window of level samples. Fixed precision 24.8 */
+static uint8 estimatorHead = 0u;            /* Oldest sample in the window */
+static uint8 estimatorCount = 0u;           /* Samples in the window */
+static int32 estimatorSum = 0;              /* Sum of the samples */
+static int32 estimatorIndexSum = 0;         /* Sum of the samples weighted by their position in the window */
+
+
+/*******************************************************************************
+* Function Name: EstimatorReset
+********************************************************************************/
+/* Empty the sliding window, e.g. after a refill. */
+static void EstimatorReset(void)
+{
+    estimatorHead = 0u;
+    estimatorCount = 0u;
+    estimatorSum = 0;
+    estimatorIndexSum = 0;
+    consumptionRate = 0u;
+    timeToEmpty = ESTIMATOR_UNKNOWN;
+}
+
+/*******************************************************************************
+* Function Name: EstimatorUpdate
+********************************************************************************/
+/* Scheduler task that runs every ESTIMATOR_SAMPLE_PERIOD_MS. It samples the level and    */
+/* fits a line through the sliding window by least squares. The sums are updated          */
+/* incrementally, so each sample costs a fixed amount of work regardless of the window     */
+/* length. A level rise of more than ESTIMATOR_REFILL_PERCENT is a refill and restarts     */
+/* the window. Updates consumptionRate and timeToEmpty and publishes them to the BLE client. */
+void EstimatorUpdate(void)
+{
+    uint8 tail;
+    int32 oldest;
+    int32 n;
+    int32 slope;        /* Least squares slope numerator */
+    uint32 denominator; /* Least squares slope denominator */
+    uint32 rate;
+    uint32 samples;
+    
+    /* Restart after a refill */
+    if(estimatorCount > 0u)
+    {
+        tail = (estimatorHead + estimatorCount - 1u) % ESTIMATOR_WINDOW;
+        if(levelPercent > (estimatorLevel[tail] + ESTIMATOR_REFILL_PERCENT))
+        {
+            EstimatorReset();
+        }
+    }
+    
+    if(estimatorCount < ESTIMATOR_WINDOW)
+    {
+        tail = (estimatorHead + estimatorCount) % ESTIMATOR_WINDOW;
+        estimatorIndexSum += (int32)estimatorCount * levelPercent;
+        estimatorCount++;
+    }
+    else
+    {
+        /* Drop the oldest sample. Every other sample moves down one position */
+        oldest = estimatorLevel[estimatorHead];
+        tail = estimatorHead;
+        estimatorHead = (estimatorHead + 1u) % ESTIMATOR_WINDOW;
+        estimatorSum -= oldest;
+        estimatorIndexSum -= estimatorSum;
+        estimatorIndexSum += (int32)(ESTIMATOR_WINDOW - 1u) * levelPercent;
+    }
+    estimatorLevel[tail] = levelPercent;
+    estimatorSum += levelPercent;
+    
+    if(estimatorCount < ESTIMATOR_MIN_SAMPLES)
+    {
+        return;
+    }
+    
+    /* slope = (n * sum(k * y) - sum(k) * sum(y)) / (n * sum(k^2) - sum(k)^2), sum(k) = n(n - 1) / 2 */
+    n = estimatorCount;
+    slope = (n * estimatorIndexSum) - (((n * (n - 1)) >> 1) * estimatorSum);
+    denominator = (uint32)((n * n) * ((n * n) - 1)) / 12u;
+    
+    if(slope >= 0)
+    {
+        /* Level is not dropping */
+        consumptionRate = 0u;
+        timeToEmpty = ESTIMATOR_UNKNOWN;
+    }
+    else
+    {
+        /* Percent per hour in fixed precision 8.8. The slope keeps 4 extra fractional bits until the end */
+        rate = (((uint32)(-slope) << 4) / denominator) * (3600000u / ESTIMATOR_SAMPLE_PERIOD_MS) >> 4;
+        consumptionRate = (rate > 0xFFFFu) ? 0xFFFFu : (uint16)rate;
+        
+        /* Samples until empty, then minutes */
+        samples = ((uint32)levelPercent * denominator) / (uint32)(-slope);
+        if(samples >= ((ESTIMATOR_UNKNOWN * 60u) / (ESTIMATOR_SAMPLE_PERIOD_MS / 1000u)))
+        {
+            timeToEmpty = ESTIMATOR_UNKNOWN - 1u;
+        }
+        else
+        {
+            timeToEmpty = (uint16)((samples * (ESTIMATOR_SAMPLE_PERIOD_MS / 1000u)) / 60u);
+        }
+    }
+    
+    UpdateEstimatorAttribute(timeToEmpty, consumptionRate);
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,59 @@
+/*****************************************************************************
+* File Name: estimator.h
+*
+* Version: 1.00
+*
+* Description: Liquid consumption rate and time-to-empty estimation.
+*
+* Related Document: Code example CE202479
+*
+* Hardware Dependency: See code example CE202479
+*
+******************************************************************************
+* Copyright (2015), Cypress Semiconductor Corporation.
+******************************************************************************
+* This software is owned by Cypress Semiconductor Corporation (Cypress) and is
+* protected by and subject to worldwide patent protection (United States and
+* foreign), United States copyright laws and international treaty provisions.
+* Cypress hereby grants to licensee a personal, non-exclusive, non-transferable
+* license to copy, use, modify, create derivative works of, and compile the
+* Cypress Source Code and derivative works for the sole purpose of creating
+* custom software in support of licensee product to be used only in conjunction
+* with a Cypress integrated circuit as specified in the applicable agreement.
+* Any reproduction, modification, translation, compilation, or representation of
+* this software except as specified above is prohibited without the express
+* written permission of Cypress.
+*
+* Disclaimer: CYPRESS MAKES NO WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, WITH
+* REGARD TO THIS MATERIAL, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+* Cypress reserves the right to make changes without further notice to the
+* materials described herein. Cypress does not assume any liability arising out
+* of the application or use of any product or circuit described herein. Cypress
+* does not authorize its products for use as critical components in life-support
+* systems where a malfunction or failure may reasonably be expected to result in
+* significant injury to the user. The inclusion of Cypress' product in a life-
+* support systems application implies that the manufacturer assumes all risk of
+* such use and in doing so indemnifies Cypress against all charges. Use may be
+* limited by and subject to the applicable Cypress software license agreement.
+*****************************************************************************/
+#if !defined(_ESTIMATOR_H)
+#define _ESTIMATOR_H
+    
+#include <project.h>
+
+
+/* Function prototypes */
+void EstimatorUpdate(void);
+
+/* Project Constants */
+#define ESTIMATOR_WINDOW            (32u)           /* Level samples in the sliding window */
+#define ESTIMATOR_SAMPLE_PERIOD_MS  (30000u)        /* Time between level samples. The window spans 16 minutes */
+#define ESTIMATOR_MIN_SAMPLES       (8u)            /* Samples needed before an estimate is published */
+#define ESTIMATOR_REFILL_PERCENT    (5 << 8)        /* Level rise that is treated as a refill. Fixed precision 24.8 */
+#define ESTIMATOR_UNKNOWN           (0xFFFFu)       /* Time to empty when no consumption is measured */
+#define ESTIMATOR_DATA_LEN          (4u)            /* Time to empty and consumption rate, both uint16 */
+
+#endif /* _ESTIMATOR_H */
+
+/* [] END OF FILE */
@@ -0,0 +1,238 @@
+/*****************************************************************************
+* File Name: filter.c
+*
+* Version: 1.00
+*
+* Description: Per-sensor streaming filters for CapSense raw counts.
+*
+* Related Document: Code example CE202479
+*
+* Hardware Dependency: See code example CE202479
+*
+******************************************************************************
+* Copyright (2015), Cypress Semiconductor Corporation.
+******************************************************************************
+* This software is owned by Cypress Semiconductor Corporation (Cypress) and is
+* protected by and subject to worldwide patent protection (United States and
+* foreign), United States copyright laws and international treaty provisions.
+* Cypress hereby grants to licensee a personal, non-exclusive, non-transferable
+* license to copy, use, modify, create derivative works of, and compile the
+* Cypress Source Code and derivative works for the sole purpose of creating
+* custom software in support of licensee product to be used only in conjunction
+* with a Cypress integrated circuit as specified in the applicable agreement.
+* Any reproduction, modification, translation, compilation, or representation of
+* this software except as specified above is prohibited without the express
+* written permission of Cypress.
+*
+* Disclaimer: CYPRESS MAKES NO WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, WITH
+* REGARD TO THIS MATERIAL, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+* Cypress reserves the right to make changes without further notice to the
+* materials described herein. Cypress does not assume any liability arising out
+* of the application or use of any product or circuit described herein. Cypress
+* does not authorize its products for use as critical components in life-support
+* systems where a malfunction or failure may reasonably be expected to result in
+* significant injury to the user. The inclusion of Cypress' product in a life-
+* support systems application implies that the manufacturer assumes all risk of
+* such use and in doing so indemnifies Cypress against all charges. Use may be
+* limited by and subject to the applicable Cypress software license agreement.
+*****************************************************************************/
+#include <project.h>
+#include <main.h>
+#include <filter.h>
+
+
+/* Per-sensor filter state. History words are taken from filterArena */
+typedef struct
+{
+    uint16 *median;     /* Last medianSize raw counts */
+    uint16 *iir;        /* IIR filter output times 2^iirShift, low and high word, so no fraction is lost */
+    uint16 *jitter;     /* Jitter filter output */
+    uint8 medianIndex;  /* Oldest entry in median */
+    uint8 primed;       /* Cleared until the history is seeded with the first sample */
+} FILTER_STATE;
+
+/* Global variables */
+/* Global variables used because this is the method uProbe uses to access firmware data */
+FILTER_CONFIG filterConfig[NUMSENSORS] =    /* Filter configuration of each sensor. Applied by FilterInit */
+{
+    {FILTER_UNSET, 0u, 0u}, {FILTER_UNSET, 0u, 0u}, {FILTER_UNSET, 0u, 0u}, {FILTER_UNSET, 0u, 0u},
+    {FILTER_UNSET, 0u, 0u}, {FILTER_UNSET, 0u, 0u}, {FILTER_UNSET, 0u, 0u}, {FILTER_UNSET, 0u, 0u},
+    {FILTER_UNSET, 0u, 0u}, {FILTER_UNSET, 0u, 0u}, {FILTER_UNSET, 0u, 0u}, {FILTER_UNSET, 0u, 0u}
+};
+uint16 filterArenaUsed = 0u;                /* History words allocated from the arena */
+uint8 filterArenaOverflow = FALSE;          /* Set if a sensor was left unfiltered because the arena is full */
+
+/* Static variables */
+static uint16 filterArena[FILTER_ARENA_SIZE];
+static FILTER_STATE filterState[NUMSENSORS];
+
+
+/*******************************************************************************
+* Function Name: FilterAlloc
+********************************************************************************/
+/* Take count history words from the arena. Returns 0 if the arena is full. */
+static uint16 *FilterAlloc(uint8 count)
+{
+    uint16 *block;
+    
+    if((filterArenaUsed + count) > FILTER_ARENA_SIZE)
+    {
+        filterArenaOverflow = TRUE;
+        return 0;
+    }
+    block = &filterArena[filterArenaUsed];
+    filterArenaUsed += count;
+    return block;
+}
+
+/*******************************************************************************
+* Function Name: FilterInit
+********************************************************************************/
+/* Apply filterConfig and carve the history buffers of every sensor out of the arena.  */
+/* Sensors left at FILTER_UNSET get the default filters, FILTER_NONE leaves a sensor    */
+/* unfiltered. Call again after changing filterConfig to restart all filters.           */
+void FilterInit(void)
+{
+    uint8 i;
+    FILTER_CONFIG *config;
+    FILTER_STATE *state;
+    
+    filterArenaUsed = 0u;
+    filterArenaOverflow = FALSE;
+    
+    for(i = 0; i < NUMSENSORS; i++)
+    {
+        config = &filterConfig[i];
+        state = &filterState[i];
+        
+        if(config->type == FILTER_UNSET)
+        {
+            config->type = FILTER_DEFAULT_TYPE;
+            config->medianSize = FILTER_DEFAULT_MEDIAN;
+            config->iirShift = FILTER_DEFAULT_IIR;
+        }
+        if((config->medianSize == 0u) || (config->medianSize > FILTER_MEDIAN_SIZE_MAX))
+        {
+            config->medianSize = FILTER_DEFAULT_MEDIAN;
+        }
+        if((config->iirShift == 0u) || (config->iirShift > FILTER_IIR_SHIFT_MAX))
+        {
+            config->iirShift = FILTER_DEFAULT_IIR;
+        }
+        
+        state->median = (config->type & FILTER_MEDIAN) ? FilterAlloc(config->medianSize) : 0;
+        state->iir = (config->type & FILTER_IIR) ? FilterAlloc(2u) : 0;
+        state->jitter = (config->type & FILTER_JITTER) ? FilterAlloc(1u) : 0;
+        state->medianIndex = 0u;
+        state->primed = FALSE;
+    }
+}
+
+/*******************************************************************************
+* Function Name: FilterMedian
+********************************************************************************/
+/* Store sample in the moving median window and return the median of the window. */
+static uint16 FilterMedian(FILTER_STATE *state, uint8 size, uint16 sample)
+{
+    uint16 sorted[FILTER_MEDIAN_SIZE_MAX];
+    uint16 value;
+    uint8 i;
+    uint8 j;
+    
+    state->median[state->medianIndex] = sample;
+    if(++state->medianIndex >= size)
+    {
+        state->medianIndex = 0u;
+    }
+    
+    /* Insertion sort, the window is at most FILTER_MEDIAN_SIZE_MAX entries */
+    for(i = 0; i < size; i++)
+    {
+        value = state->median[i];
+        for(j = i; (j > 0u) && (sorted[j - 1u] > value); j--)
+        {
+            sorted[j] = sorted[j - 1u];
+        }
+        sorted[j] = value;
+    }
+    return sorted[size >> 1];
+}
+
+/*******************************************************************************
+* Function Name: FilterProcessFrame
+********************************************************************************/
+/* Run the configured filters of every sensor over a new frame of raw counts    */
+/* and write the result to filtered, raw is left as scanned. Only the sensors   */
+/* in sensorMask have a new sample, the filter state and filtered count of the  */
+/* others are left as they are.                                                 */
+void FilterProcessFrame(const uint16 raw[], uint16 filtered[], uint16 sensorMask)
+{
+    uint8 i;
+    uint8 j;
+    uint16 sample;
+    uint32 iir;
+    FILTER_CONFIG *config = filterConfig;
+    FILTER_STATE *state = filterState;
+    
+    for(i = 0; i < NUMSENSORS; i++, config++, state++)
+    {
+        if((sensorMask & (1u << i)) == 0u)
+        {
+            continue;
+        }
+        sample = raw[i];
+        
+        /* Seed the history so the filters start from the first sample instead of zero */
+        if(!state->primed)
+        {
+            for(j = 0; (state->median != 0) && (j < config->medianSize); j++)
+            {
+                state->median[j] = sample;
+            }
+            if(state->iir != 0)
+            {
+                iir = (uint32)sample << config->iirShift;
+                state->iir[0] = LO16(iir);
+                state->iir[1] = HI16(iir);
+            }
+            if(state->jitter != 0)
+            {
+                *state->jitter = sample;
+            }
+            state->primed = TRUE;
+        }
+        
+        if(state->median != 0)
+        {
+            sample = FilterMedian(state, config->medianSize, sample);
+        }
+        if(state->iir != 0)
+        {
+            /* y = y + (x - y) / 2^shift. The state keeps the fraction, a rounded state would stop */
+            /* up to 2^(shift - 1) counts short of a steady input */
+            iir = state->iir[0] | ((uint32)state->iir[1] << 16);
+            iir = iir - (iir >> config->iirShift) + sample;
+            state->iir[0] = LO16(iir);
+            state->iir[1] = HI16(iir);
+            sample = (uint16)((iir + (1u << (config->iirShift - 1u))) >> config->iirShift);
+        }
+        if(state->jitter != 0)
+        {
+            /* Follow the input only when it moves by more than one count */
+            if(sample > (*state->jitter + 1u))
+            {
+                *state->jitter = sample - 1u;
+            }
+            else if((sample + 1u) < *state->jitter)
+            {
+                *state->jitter = sample + 1u;
+            }
+            sample = *state->jitter;
+        }
+        
+        filtered[i] = sample;
+    }
+}
+
+/* [] END OF FILE */
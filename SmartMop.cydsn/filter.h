@@ -0,0 +1,77 @@
+/*****************************************************************************
+* File Name: filter.h
+*
+* Version: 1.00
+*
+* Description: Per-sensor streaming filters for CapSense raw counts.
+*
+* Related Document: Code example CE202479
+*
+* Hardware Dependency: See code example CE202479
+*
+******************************************************************************
+* Copyright (2015), Cypress Semiconductor Corporation.
+******************************************************************************
+* This software is owned by Cypress Semiconductor Corporation (Cypress) and is
+* protected by and subject to worldwide patent protection (United States and
+* foreign), United States copyright laws and international treaty provisions.
+* Cypress hereby grants to licensee a personal, non-exclusive, non-transferable
+* license to copy, use, modify, create derivative works of, and compile the
+* Cypress Source Code and derivative works for the sole purpose of creating
+* custom software in support of licensee product to be used only in conjunction
+* with a Cypress integrated circuit as specified in the applicable agreement.
+* Any reproduction, modification, translation, compilation, or representation of
+* this software except as specified above is prohibited without the express
+* written permission of Cypress.
+*
+* Disclaimer: CYPRESS MAKES NO WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, WITH
+* REGARD TO THIS MATERIAL, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+* Cypress reserves the right to make changes without further notice to the
+* materials described herein. Cypress does not assume any liability arising out
+* of the application or use of any product or circuit described herein. Cypress
+* does not authorize its products for use as critical components in life-support
+* systems where a malfunction or failure may reasonably be expected to result in
+* significant injury to the user. The inclusion of Cypress' product in a life-
+* support systems application implies that the manufacturer assumes all risk of
+* such use and in doing so indemnifies Cypress against all charges. Use may be
+* limited by and subject to the applicable Cypress software license agreement.
+*****************************************************************************/
+#if !defined(_FILTER_H)
+#define _FILTER_H
+    
+#include <project.h>
+#include <main.h>
+
+
+/* Filter configuration of one sensor */
+typedef struct
+{
+    uint8 type;         /* Combination of FILTER_MEDIAN, FILTER_IIR and FILTER_JITTER, applied in that order */
+    uint8 medianSize;   /* Moving median window in frames, 1..FILTER_MEDIAN_SIZE_MAX */
+    uint8 iirShift;     /* IIR filter weight is 1 / 2^iirShift */
+} FILTER_CONFIG;
+
+/* Function prototypes */
+void FilterInit(void);
+void FilterProcessFrame(const uint16 raw[], uint16 filtered[], uint16 sensorMask);
+
+/* Project Constants */
+/* Filter types */
+#define FILTER_NONE             (0x00u)         /* Counts pass unfiltered */
+#define FILTER_MEDIAN           (0x01u)         /* Moving median over medianSize frames */
+#define FILTER_IIR              (0x02u)         /* First order IIR low pass */
+#define FILTER_JITTER           (0x04u)         /* Removes +/-1 count jitter */
+#define FILTER_UNSET            (0xFFu)         /* Replaced with the default filters by FilterInit */
+/* Filter limits */
+#define FILTER_MEDIAN_SIZE_MAX  (5u)            /* Largest supported moving median window */
+#define FILTER_IIR_SHIFT_MAX    (4u)            /* Smallest supported IIR weight is 1/16 */
+#define FILTER_ARENA_SIZE       (NUMSENSORS * (FILTER_MEDIAN_SIZE_MAX + 3u)) /* History words for all sensors with every filter enabled */
+/* Default filter configuration */
+#define FILTER_DEFAULT_TYPE     (FILTER_MEDIAN | FILTER_IIR)
+#define FILTER_DEFAULT_MEDIAN   (3u)
+#define FILTER_DEFAULT_IIR      (2u)
+
+#endif /* _FILTER_H */
+
+/* [] END OF FILE */
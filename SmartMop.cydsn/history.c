@@ -0,0 +1,243 @@
+/*****************************************************************************
+* File Name: history.c
+*
+* Version: 1.00
+*
+* Description: Offline level history ring buffer in RAM and flash.
+*
+* Related Document: Code example CE202479
+*
+* Hardware Dependency: See code example CE202479
+*
+******************************************************************************
+* Copyright (2015), Cypress Semiconductor Corporation.
+******************************************************************************
+* This software is owned by Cypress Semiconductor Corporation (Cypress) and is
+* protected by and subject to worldwide patent protection (United States and
+* foreign), United States copyright laws and international treaty provisions.
+* Cypress hereby grants to licensee a personal, non-exclusive, non-transferable
+* license to copy, use, modify, create derivative works of, and compile the
+* Cypress Source Code and derivative works for the sole purpose of creating
+* custom software in support of licensee product to be used only in conjunction
+* with a Cypress integrated circuit as specified in the applicable agreement.
+* Any reproduction, modification, translation, compilation, or representation of
+* this software except as specified above is prohibited without the express
+* written permission of Cypress.
+*
+* Disclaimer: CYPRESS MAKES NO WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, WITH
+* REGARD TO THIS MATERIAL, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+* Cypress reserves the right to make changes without further notice to the
+* materials described herein. Cypress does not assume any liability arising out
+* of the application or use of any product or circuit described herein. Cypress
+* does not authorize its products for use as critical components in life-support
+* systems where a malfunction or failure may reasonably be expected to result in
+* significant injury to the user. The inclusion of Cypress' product in a life-
+* support systems application implies that the manufacturer assumes all risk of
+* such use and in doing so indemnifies Cypress against all charges. Use may be
+* limited by and subject to the applicable Cypress software license agreement.
+*****************************************************************************/
+#include <project.h>
+#include <main.h>
+#include <history.h>
+#include <calibration.h>
+
+
+/* Global variables */
+/* Global variables used because this is the method uProbe uses to access firmware data */
+uint32 historyCount = 0u;                   /* Samples recorded since power-up, the number of the next sample */
+uint32 historySynced = 0u;                  /* Number of the first sample not yet sent to a Central device */
+uint32 historyQueued = 0u;                  /* Number of the first sample not in the notification queue, historySynced or later */
+uint32 historyOverwritten = 0u;             /* Samples overwritten in flash before they were sent */
+uint16 historyFlashWrites = 0u;             /* Rows spilled to flash */
+uint16 historyFlashErrors = 0u;             /* Rows lost because the flash write failed */
+/* External globals */
+extern uint8 DeviceConnected;
+extern int32 levelPercent;
+extern uint8 sensorActiveCount;
+extern uint8 motionSloshing;
+extern uint8 calScaleState;
+extern volatile uint32 systemTimeMs;
+
+/* Static variables */
+static uint8 historyRow[CY_FLASH_SIZEOF_ROW]; /* Row being filled, spilled to flash when full */
+static uint8 historyPackedCount = 0u;       /* Samples in the last packed notification */
+/* Ring of full rows. Flash is kept across resets, but the samples are only valid since power-up */
+static const uint8 CYCODE historyFlash[HISTORY_FLASH_ROWS * CY_FLASH_SIZEOF_ROW] CY_ALIGN(CY_FLASH_SIZEOF_ROW) = {0u};
+
+
+/*******************************************************************************
+* Function Name: HistorySample
+********************************************************************************/
+/* Location of a sample, in the RAM row if its row is not full yet, else in flash. */
+static const uint8 *HistorySample(uint32 sample)
+{
+    uint32 row = sample / HISTORY_ROW_SAMPLES;
+    uint32 offset = (sample % HISTORY_ROW_SAMPLES) * HISTORY_SAMPLE_LEN;
+    
+    if(row == (historyCount / HISTORY_ROW_SAMPLES))
+    {
+        return &historyRow[offset];
+    }
+    return &historyFlash[((row % HISTORY_FLASH_ROWS) * CY_FLASH_SIZEOF_ROW) + offset];
+}
+
+/*******************************************************************************
+* Function Name: HistoryRecord
+********************************************************************************/
+/* Scheduler task that runs every HISTORY_SAMPLE_PERIOD_MS. While no Central device */
+/* is connected it adds the level to the RAM row, and spills the row to the flash   */
+/* ring when it is full. A connected Central device gets the level notifications.   */
+void HistoryRecord(void)
+{
+    uint8 *sample;
+    uint8 flags = 0u;
+    uint32 row;
+    int32 percent = levelPercent;
+    
+    if(DeviceConnected)
+    {
+        return;
+    }
+    
+    if(percent < 0)
+    {
+        percent = 0;
+    }
+    if(motionSloshing)
+    {
+        flags |= LEVEL_NTF_FLAG_SLOSHING;
+    }
+    if(calScaleState == CAL_SCALE_RUNNING)
+    {
+        flags |= LEVEL_NTF_FLAG_FULL_SCALE;
+    }
+    
+    sample = &historyRow[(historyCount % HISTORY_ROW_SAMPLES) * HISTORY_SAMPLE_LEN];
+    sample[HISTORY_SAMPLE_TIME] = LO8(systemTimeMs);
+    sample[HISTORY_SAMPLE_TIME + 1u] = HI8(systemTimeMs);
+    sample[HISTORY_SAMPLE_TIME + 2u] = LO8(HI16(systemTimeMs));
+    sample[HISTORY_SAMPLE_TIME + 3u] = HI8(HI16(systemTimeMs));
+    sample[HISTORY_SAMPLE_PERCENT] = LO8(percent);
+    sample[HISTORY_SAMPLE_PERCENT + 1u] = HI8(percent);
+    sample[HISTORY_SAMPLE_ACTIVE_COUNT] = sensorActiveCount;
+    sample[HISTORY_SAMPLE_FLAGS] = flags;
+    historyCount++;
+    
+    if((historyCount % HISTORY_ROW_SAMPLES) == 0u)
+    {
+        row = ((historyCount / HISTORY_ROW_SAMPLES) - 1u) % HISTORY_FLASH_ROWS;
+        if(Em_EEPROM_Write(historyRow, &historyFlash[row * CY_FLASH_SIZEOF_ROW], CY_FLASH_SIZEOF_ROW) == CYRET_SUCCESS)
+        {
+            historyFlashWrites++;
+        }
+        else
+        {
+            historyFlashErrors++;
+        }
+    }
+}
+
+/*******************************************************************************
+* Function Name: HistoryPack
+********************************************************************************/
+/* Pack the oldest samples not queued yet into a history notification of at     */
+/* most length bytes and return its length. Returns HISTORY_NTF_SAMPLES, a       */
+/* header without samples, when everything was queued. The samples count as     */
+/* queued after HistoryQueue and as sent after HistoryAcknowledge, so a          */
+/* notification the stack did not accept is repacked.                           */
+uint16 HistoryPack(uint8 buffer[], uint16 length)
+{
+    uint32 oldest = 0u;
+    uint32 count;
+    uint32 i;
+    uint8 j;
+    const uint8 *sample;
+    
+    /* Rows older than the flash ring were overwritten */
+    if((historyCount / HISTORY_ROW_SAMPLES) > HISTORY_FLASH_ROWS)
+    {
+        oldest = ((historyCount / HISTORY_ROW_SAMPLES) - HISTORY_FLASH_ROWS) * HISTORY_ROW_SAMPLES;
+    }
+    if(historySynced < oldest)
+    {
+        historyOverwritten += oldest - historySynced;
+        historySynced = oldest;
+    }
+    if(historyQueued < historySynced)
+    {
+        historyQueued = historySynced;
+    }
+    
+    count = historyCount - historyQueued;
+    if(count > ((uint32)(length - HISTORY_NTF_SAMPLES) / HISTORY_SAMPLE_LEN))
+    {
+        count = (uint32)(length - HISTORY_NTF_SAMPLES) / HISTORY_SAMPLE_LEN;
+    }
+    if(count > 0xFFu)
+    {
+        count = 0xFFu;
+    }
+    
+    buffer[HISTORY_NTF_SEQUENCE] = LO8(historyQueued);
+    buffer[HISTORY_NTF_SEQUENCE + 1u] = HI8(historyQueued);
+    buffer[HISTORY_NTF_SEQUENCE + 2u] = LO8(HI16(historyQueued));
+    buffer[HISTORY_NTF_SEQUENCE + 3u] = HI8(HI16(historyQueued));
+    buffer[HISTORY_NTF_COUNT] = (uint8)count;
+    
+    for(i = 0u; i < count; i++)
+    {
+        sample = HistorySample(historyQueued + i);
+        for(j = 0u; j < HISTORY_SAMPLE_LEN; j++)
+        {
+            buffer[HISTORY_NTF_SAMPLES + (i * HISTORY_SAMPLE_LEN) + j] = sample[j];
+        }
+    }
+    historyPackedCount = (uint8)count;
+    
+    return (uint16)(HISTORY_NTF_SAMPLES + (count * HISTORY_SAMPLE_LEN));
+}
+
+/*******************************************************************************
+* Function Name: HistoryQueue
+********************************************************************************/
+/* Mark the samples of the last packed notification as queued. */
+void HistoryQueue(void)
+{
+    historyQueued += historyPackedCount;
+    historyPackedCount = 0u;
+}
+
+/*******************************************************************************
+* Function Name: HistoryAcknowledge
+********************************************************************************/
+/* Notification queue handler of a history notification. The samples count as  */
+/* sent when the stack accepted the notification that continues historySynced.  */
+/* When a notification was dropped, everything from historySynced is packed     */
+/* again. Notifications queued after it may still be sent, the Central device   */
+/* removes the repeated samples by their number.                                */
+void HistoryAcknowledge(const uint8 data[], uint8 sent)
+{
+    uint32 sequence = (uint32)data[HISTORY_NTF_SEQUENCE] | ((uint32)data[HISTORY_NTF_SEQUENCE + 1u] << 8) |
+        ((uint32)data[HISTORY_NTF_SEQUENCE + 2u] << 16) | ((uint32)data[HISTORY_NTF_SEQUENCE + 3u] << 24);
+    
+    if(!sent)
+    {
+        historyQueued = historySynced;
+    }
+    else if(sequence == historySynced)
+    {
+        historySynced += data[HISTORY_NTF_COUNT];
+    }
+}
+
+/*******************************************************************************
+* Function Name: HistoryPending
+********************************************************************************/
+/* TRUE while queued samples wait for the stack. */
+uint8 HistoryPending(void)
+{
+    return (historyQueued != historySynced);
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,74 @@
+/*****************************************************************************
+* File Name: history.h
+*
+* Version: 1.00
+*
+* Description: Offline level history ring buffer in RAM and flash.
+*
+* Related Document: Code example CE202479
+*
+* Hardware Dependency: See code example CE202479
+*
+******************************************************************************
+* Copyright (2015), Cypress Semiconductor Corporation.
+******************************************************************************
+* This software is owned by Cypress Semiconductor Corporation (Cypress) and is
+* protected by and subject to worldwide patent protection (United States and
+* foreign), United States copyright laws and international treaty provisions.
+* Cypress hereby grants to licensee a personal, non-exclusive, non-transferable
+* license to copy, use, modify, create derivative works of, and compile the
+* Cypress Source Code and derivative works for the sole purpose of creating
+* custom software in support of licensee product to be used only in conjunction
+* with a Cypress integrated circuit as specified in the applicable agreement.
+* Any reproduction, modification, translation, compilation, or representation of
+* this software except as specified above is prohibited without the express
+* written permission of Cypress.
+*
+* Disclaimer: CYPRESS MAKES NO WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, WITH
+* REGARD TO THIS MATERIAL, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+* Cypress reserves the right to make changes without further notice to the
+* materials described herein. Cypress does not assume any liability arising out
+* of the application or use of any product or circuit described herein. Cypress
+* does not authorize its products for use as critical components in life-support
+* systems where a malfunction or failure may reasonably be expected to result in
+* significant injury to the user. The inclusion of Cypress' product in a life-
+* support systems application implies that the manufacturer assumes all risk of
+* such use and in doing so indemnifies Cypress against all charges. Use may be
+* limited by and subject to the applicable Cypress software license agreement.
+*****************************************************************************/
+#if !defined(_HISTORY_H)
+#define _HISTORY_H
+    
+#include <project.h>
+#include <main.h>
+
+
+/* Function prototypes */
+void HistoryRecord(void);
+uint16 HistoryPack(uint8 buffer[], uint16 length);
+void HistoryQueue(void);
+void HistoryAcknowledge(const uint8 data[], uint8 sent);
+uint8 HistoryPending(void);
+
+/* Project Constants */
+#define HISTORY_SAMPLE_PERIOD_MS    (300000u)       /* Time between two samples while no Central device is connected */
+#define HISTORY_FLASH_ROWS          (32u)           /* Flash rows of history, 512 samples or 42 hours */
+
+/* Sample, little endian. Kept in this layout in RAM, flash and the history notification */
+#define HISTORY_SAMPLE_TIME         (0u)            /* uint32 systemTimeMs */
+#define HISTORY_SAMPLE_PERCENT      (4u)            /* uint16 levelPercent, fixed precision 8.8 */
+#define HISTORY_SAMPLE_ACTIVE_COUNT (6u)            /* uint8 sensorActiveCount, in half sensors */
+#define HISTORY_SAMPLE_FLAGS        (7u)            /* uint8 LEVEL_NTF_FLAG_ bits */
+#define HISTORY_SAMPLE_LEN          (8u)
+#define HISTORY_ROW_SAMPLES         (CY_FLASH_SIZEOF_ROW / HISTORY_SAMPLE_LEN)
+
+/* History notification: header followed by up to 255 samples, oldest first.
+*  A notification without samples ends the transfer */
+#define HISTORY_NTF_SEQUENCE        (0u)            /* uint32 number of the first sample since power-up, gaps show lost samples */
+#define HISTORY_NTF_COUNT           (4u)            /* uint8 samples in this notification */
+#define HISTORY_NTF_SAMPLES         (5u)
+
+#endif /* _HISTORY_H */
+
+/* [] END OF FILE */
@@ -0,0 +1,137 @@
+/*****************************************************************************
+* File Name: ilo.c
+*
+* Version: 1.00
+*
+* Description: Periodic ILO measurement against the IMO and drift reporting.
+*
+* Related Document: Code example CE202479
+*
+* Hardware Dependency: See code example CE202479
+*
+******************************************************************************
+* Copyright (2015), Cypress Semiconductor Corporation.
+******************************************************************************
+* This software is owned by Cypress Semiconductor Corporation (Cypress) and is
+* protected by and subject to worldwide patent protection (United States and
+* foreign), United States copyright laws and international treaty provisions.
+* Cypress hereby grants to licensee a personal, non-exclusive, non-transferable
+* license to copy, use, modify, create derivative works of, and compile the
+* Cypress Source Code and derivative works for the sole purpose of creating
+* custom software in support of licensee product to be used only in conjunction
+* with a Cypress integrated circuit as specified in the applicable agreement.
+* Any reproduction, modification, translation, compilation, or representation of
+* this software except as specified above is prohibited without the express
+* written permission of Cypress.
+*
+* Disclaimer: CYPRESS MAKES NO WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, WITH
+* REGARD TO THIS MATERIAL, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+* Cypress reserves the right to make changes without further notice to the
+* materials described herein. Cypress does not assume any liability arising out
+* of the application or use of any product or circuit described herein. Cypress
+* does not authorize its products for use as critical components in life-support
+* systems where a malfunction or failure may reasonably be expected to result in
+* significant injury to the user. The inclusion of Cypress' product in a life-
+* support systems application implies that the manufacturer assumes all risk of
+* such use and in doing so indemnifies Cypress against all charges. Use may be
+* limited by and subject to the applicable Cypress software license agreement.
+*****************************************************************************/
+#include <project.h>
+#include <main.h>
+#include <ilo.h>
+#include <scheduler.h>
+
+
+/* Global variables */
+/* Global variables used because this is the method uProbe uses to access firmware data */
+uint32 iloCounts = ILO_NOMINAL_COUNTS;      /* ILO cycles in ILO_REFERENCE_MS, last measurement */
+int32 iloErrorPpm = 0;                      /* ILO frequency error against 32 kHz in ppm, last measurement */
+int32 iloErrorMinPpm = 0;                   /* Lowest iloErrorPpm since power-up */
+int32 iloErrorMaxPpm = 0;                   /* Highest iloErrorPpm since power-up */
+int32 iloDriftPpm = 0;                      /* Change of iloErrorPpm since the previous measurement */
+uint16 iloMeasureCount = 0u;                /* Completed measurements */
+uint16 iloFailCount = 0u;                   /* Abandoned measurements */
+uint8 iloMeasuring = FALSE;                 /* Set while the IMO counts ILO cycles. DeepSleep would stop the count */
+
+/* Static variables */
+static uint8 iloPolls = 0u;
+
+
+/*******************************************************************************
+* Function Name: IloServiceRun
+********************************************************************************/
+/* Scheduler task body. Starts an ILO measurement every ILO_RECAL_PERIOD_MS and    */
+/* polls it every ILO_POLL_MS until CySysClkIloCompensate has a result, so the     */
+/* main loop is never blocked. The task reschedules itself.                        */
+/* Returns ILO_DONE when iloCounts was updated. The caller then rewrites the WDT   */
+/* match values, iloCounts itself only changes here in the main loop.              */
+uint8 IloServiceRun(void)
+{
+    uint32 counts = 0u;
+    int32 errorPpm;
+    cystatus rc;
+    
+    if(!iloMeasuring)
+    {
+        CySysClkIloStartMeasurement();
+        iloMeasuring = TRUE;
+        iloPolls = 0u;
+    }
+    
+    rc = CySysClkIloCompensate(ILO_REFERENCE_MS * 1000u, &counts);
+    
+    if((rc != CYRET_SUCCESS) && (++iloPolls < ILO_POLL_LIMIT))
+    {
+        SchedulerStart(SCHEDULER_TASK_ILO, ILO_POLL_MS, SCHEDULER_ONE_SHOT);
+        return ILO_BUSY;
+    }
+    
+    CySysClkIloStopMeasurement();
+    iloMeasuring = FALSE;
+    SchedulerStart(SCHEDULER_TASK_ILO, ILO_RECAL_PERIOD_MS, ILO_RECAL_PERIOD_MS);
+    
+    /* The ILO is specified to +/-60%, anything outside is a bad measurement */
+    if((rc != CYRET_SUCCESS) || (counts < (ILO_NOMINAL_COUNTS * 2u / 5u)) || (counts > (ILO_NOMINAL_COUNTS * 8u / 5u)))
+    {
+        iloFailCount++;
+        return ILO_FAILED;
+    }
+    
+    /* ppm = difference * 1000000 / ILO_NOMINAL_COUNTS without overflowing 32 bits */
+    errorPpm = (((int32)counts - (int32)ILO_NOMINAL_COUNTS) * 1000) / (int32)(ILO_NOMINAL_COUNTS / 1000u);
+    
+    if(iloMeasureCount == 0u)
+    {
+        iloErrorMinPpm = errorPpm;
+        iloErrorMaxPpm = errorPpm;
+    }
+    else
+    {
+        iloDriftPpm = errorPpm - iloErrorPpm;
+        if(errorPpm < iloErrorMinPpm)
+        {
+            iloErrorMinPpm = errorPpm;
+        }
+        if(errorPpm > iloErrorMaxPpm)
+        {
+            iloErrorMaxPpm = errorPpm;
+        }
+    }
+    iloErrorPpm = errorPpm;
+    iloCounts = counts;
+    iloMeasureCount++;
+    
+    return ILO_DONE;
+}
+
+/*******************************************************************************
+* Function Name: IloMatchValue
+********************************************************************************/
+/* WDT match value for a period in ms from the last measurement. */
+uint32 IloMatchValue(uint32 periodMs)
+{
+    return (iloCounts * periodMs) / ILO_REFERENCE_MS;
+}
+
+/* [] END OF FILE */
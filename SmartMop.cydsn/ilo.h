@@ -0,0 +1,63 @@
+/*****************************************************************************
+* File Name: ilo.h
+*
+* Version: 1.00
+*
+* Description: Periodic ILO measurement against the IMO and drift reporting.
+*
+* Related Document: Code example CE202479
+*
+* Hardware Dependency: See code example CE202479
+*
+******************************************************************************
+* Copyright (2015), Cypress Semiconductor Corporation.
+******************************************************************************
+* This software is owned by Cypress Semiconductor Corporation (Cypress) and is
+* protected by and subject to worldwide patent protection (United States and
+* foreign), United States copyright laws and international treaty provisions.
+* Cypress hereby grants to licensee a personal, non-exclusive, non-transferable
+* license to copy, use, modify, create derivative works of, and compile the
+* Cypress Source Code and derivative works for the sole purpose of creating
+* custom software in support of licensee product to be used only in conjunction
+* with a Cypress integrated circuit as specified in the applicable agreement.
+* Any reproduction, modification, translation, compilation, or representation of
+* this software except as specified above is prohibited without the express
+* written permission of Cypress.
+*
+* Disclaimer: CYPRESS MAKES NO WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, WITH
+* REGARD TO THIS MATERIAL, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+* Cypress reserves the right to make changes without further notice to the
+* materials described herein. Cypress does not assume any liability arising out
+* of the application or use of any product or circuit described herein. Cypress
+* does not authorize its products for use as critical components in life-support
+* systems where a malfunction or failure may reasonably be expected to result in
+* significant injury to the user. The inclusion of Cypress' product in a life-
+* support systems application implies that the manufacturer assumes all risk of
+* such use and in doing so indemnifies Cypress against all charges. Use may be
+* limited by and subject to the applicable Cypress software license agreement.
+*****************************************************************************/
+#if !defined(_ILO_H)
+#define _ILO_H
+    
+#include <project.h>
+
+
+/* Function prototypes */
+uint8 IloServiceRun(void);
+uint32 IloMatchValue(uint32 periodMs);
+
+/* Project Constants */
+#define ILO_REFERENCE_MS        (500u)          /* Period the ILO is measured over */
+#define ILO_NOMINAL_COUNTS      (32u * ILO_REFERENCE_MS) /* ILO cycles in ILO_REFERENCE_MS at 32 kHz */
+#define ILO_RECAL_PERIOD_MS     (60000u)        /* Time between measurements */
+#define ILO_POLL_MS             (2u)            /* Time between polls of a running measurement */
+#define ILO_POLL_LIMIT          (50u)           /* Polls before a measurement is abandoned */
+/* IloServiceRun results */
+#define ILO_BUSY                (0u)            /* Measurement running, DeepSleep is blocked */
+#define ILO_DONE                (1u)            /* New iloCounts, the match values must be updated */
+#define ILO_FAILED              (2u)            /* Measurement abandoned, the previous iloCounts is kept */
+
+#endif /* _ILO_H */
+
+/* [] END OF FILE */
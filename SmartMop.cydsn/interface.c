@@ -40,6 +40,9 @@
 #include <project.h>
 #include <main.h>
 #include <interface.h>
+#include <calibration.h>
+#include <power.h>
+#include <profile.h>
 
 
 /* Global variables */
@@ -62,12 +65,14 @@ extern uint8 uartTxMode;
 extern int16 arrayAxisLabel[];
 extern int32 levelPercent;                 
 extern int32 levelMm; 
-extern int32 sensorRaw[];
-extern int32 sensorDiff[];
-extern int32 sensorProcessed[];
+extern uint16 sensorRaw[];
+extern int16 sensorDiff[];
+extern int16 sensorProcessed[];
 extern uint8 calFlag;
 extern int16 eepromEmptyOffset[];
 extern uint8 sensorActiveCount;
+/* Constant tables */
+static const char CYCODE uartHexDigit[16] = {'0','1','2','3','4','5','6','7','8','9','A','B','C','D','E','F'};
 
 
 
@@ -97,6 +102,47 @@ void ProcessUprobe(void)
 
 
 
+/*******************************************************************************
+* Function Name: ProcessUart
+********************************************************************************/
+/* Check for a command received on the UART and run it.                                     */
+/* UART_CMD_FULL_SCALE starts full-tank scaling. The tank must be full.                     */
+/* UART_CMD_DIAGNOSTICS prints the state residency record in the same layout as the BLE      */
+/* diagnostics characteristic, as hex after "DIAG ", for the host power model.               */
+/* UART_CMD_PROFILE sends the profiler statistics and trace in binary for host/profdump.c.   */
+void ProcessUart(void)
+{
+    uint8 record[POWER_DIAG_LEN];
+    uint8 i;
+    
+    switch(UART_UartGetChar())
+    {
+        case UART_CMD_FULL_SCALE:
+            CalibrationStartFullScale();
+            UART_UartPutString("Full-tank scaling started\r\n");
+            break;
+        case UART_CMD_DIAGNOSTICS:
+            PowerDiagnosticsPack(record);
+            UART_UartPutString("DIAG ");
+            for(i = 0u; i < POWER_DIAG_LEN; i++)
+            {
+                UART_UartPutChar(uartHexDigit[record[i] >> 4]);
+                UART_UartPutChar(uartHexDigit[record[i] & 0x0Fu]);
+            }
+            UART_UartPutString("\r\n");
+            break;
+        #if defined(PROFILE_ENABLED)
+        case UART_CMD_PROFILE:
+            ProfileDump();
+            break;
+        #endif /* PROFILE_ENABLED */
+        default:
+            break;
+    }
+}
+
+
+
 /*******************************************************************************
 * Function Name: Em_EEPROM_Write
 ********************************************************************************
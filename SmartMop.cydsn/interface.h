@@ -43,6 +43,7 @@
 /* Function prototypes */
 
 void ProcessUprobe(void);
+void ProcessUart(void);
 
 /* Project Constants */
 /* uProbe constants */  
@@ -53,6 +54,10 @@ void ProcessUprobe(void);
 #define UART_BASIC          (1u)
 #define UART_CSVINIT        (2u)
 #define UART_CSV            (3u)
+/* UART commands */
+#define UART_CMD_FULL_SCALE ('F')          /* Start full-tank scaling */
+#define UART_CMD_DIAGNOSTICS ('D')         /* Print the state residency record in hex */
+#define UART_CMD_PROFILE ('P')             /* Dump the profiler trace in binary, PROFILE_ENABLED builds only */
 
 
 /* [] END OF FILE */
@@ -0,0 +1,214 @@
+/*****************************************************************************
+* File Name: level.c
+*
+* Version: 1.00
+*
+* Description: Liquid level estimation from normalized CapSense sensor counts.
+*
+* Related Document: Code example CE202479
+*
+* Hardware Dependency: See code example CE202479
+*
+******************************************************************************
+* Copyright (2015), Cypress Semiconductor Corporation.
+******************************************************************************
+* This software is owned by Cypress Semiconductor Corporation (Cypress) and is
+* protected by and subject to worldwide patent protection (United States and
+* foreign), United States copyright laws and international treaty provisions.
+* Cypress hereby grants to licensee a personal, non-exclusive, non-transferable
+* license to copy, use, modify, create derivative works of, and compile the
+* Cypress Source Code and derivative works for the sole purpose of creating
+* custom software in support of licensee product to be used only in conjunction
+* with a Cypress integrated circuit as specified in the applicable agreement.
+* Any reproduction, modification, translation, compilation, or representation of
+* this software except as specified above is prohibited without the express
+* written permission of Cypress.
+*
+* Disclaimer: CYPRESS MAKES NO WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, WITH
+* REGARD TO THIS MATERIAL, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+* Cypress reserves the right to make changes without further notice to the
+* materials described herein. Cypress does not assume any liability arising out
+* of the application or use of any product or circuit described herein. Cypress
+* does not authorize its products for use as critical components in life-support
+* systems where a malfunction or failure may reasonably be expected to result in
+* significant injury to the user. The inclusion of Cypress' product in a life-
+* support systems application implies that the manufacturer assumes all risk of
+* such use and in doing so indemnifies Cypress against all charges. Use may be
+* limited by and subject to the applicable Cypress software license agreement.
+*****************************************************************************/
+#include <project.h>
+#include <main.h>
+#include <level.h>
+
+
+/* Global variables */
+/* Global variables used because this is the method uProbe uses to access firmware data */
+uint16 sensorRaw[NUMSENSORS] = {0u};        /* Sensor raw counts */
+uint16 sensorFiltered[NUMSENSORS] = {0u};   /* Sensor raw counts after FilterProcessFrame */
+int16 sensorDiff[NUMSENSORS] = {0u};        /* Sensor difference counts */
+int16 sensorEmptyOffset[NUMSENSORS] = {0u}; /* Sensor counts when empty to calculate diff counts. Loaded from EEPROM array */
+const int16 CYCODE eepromEmptyOffset[NUMSENSORS] = {0,1486,1864,2563,2680,1892,1905,1825,1904,2024,2086,884};/* Sensor counts when empty to calculate diff counts. Loaded from EEPROM array */
+int16 sensorScale[NUMSENSORS] = {0u};       /* Scaling factor to normalize sensor full scale counts. 0x0100 = 1.0 in fixed precision 8.8. Loaded from EEPROM array */
+const int16 CYCODE eepromScale[NUMSENSORS] = {0x01D0, 0x0100, 0x0100, 0x0100, 0x0100, 0x0100, 0x0100, 0x0100, 0x0100, 0x0100, 0x0100, 0x01C0}; /* Scaling factor to normalize sensor full scale counts. Updated by full-tank scaling */
+int16 sensorProcessed[NUMSENSORS] = {0u, 0u}; /* Sensor counts normalized to SENSORMAX at full level */
+uint16 sensorLimit = SENSORLIMIT;           /* Threshold for determining if a sensor is submerged. Set to half of SENSORMAX value */
+uint8 sensorActiveCount = 0u;               /* Number of sensors currently submerged */
+int32 levelPercent = 0u;                    /* fixed precision 24.8 */
+int32 levelMm = 0u;                         /* fixed precision 24.8 */
+int32 levelMmStep = 0u;                     /* Level from submerged sensor count only, kept for comparison. Fixed precision 24.8 */
+int32 sensorHeight = SENSORHEIGHT;          /* Height of a single sensor. Fixed precision 24.8 */
+
+/* Static variables */
+static uint16 levelReferenceRaw[NUMSENSORS]; /* Raw counts of the last processed frame */
+
+
+/*******************************************************************************
+* Function Name: LevelInit
+********************************************************************************/
+/* Load the stored empty offsets and scales from the EEPROM arrays. */
+void LevelInit(void)
+{
+    uint8 i;
+    
+    for(i = 0; i < NUMSENSORS; i++)
+    {
+        sensorEmptyOffset[i] = eepromEmptyOffset[i];
+        sensorScale[i] = eepromScale[i];
+    }
+}
+
+/*******************************************************************************
+* Function Name: LevelSaturate
+********************************************************************************/
+/* Clamp count to the int16 range of sensorDiff and sensorProcessed. */
+static inline int32 LevelSaturate(int32 count)
+{
+    if(count > LEVEL_PROCESSED_MAX)
+    {
+        return LEVEL_PROCESSED_MAX;
+    }
+    if(count < LEVEL_PROCESSED_MIN)
+    {
+        return LEVEL_PROCESSED_MIN;
+    }
+    return count;
+}
+
+/*******************************************************************************
+* Function Name: LevelProcessSensor
+********************************************************************************/
+/* Process one sensor of the frame: remove the empty offset, normalize the full scale   */
+/* count and accumulate its contribution to the step and interpolated level.           */
+/* The diff and processed counts saturate at the int16 range instead of wrapping.      */
+/* The raw count is kept as the reference for change detection.                       */
+/* The submerged fraction is processed / SENSORMAX, clamped to 0..1 and snapped close to */
+/* empty or full to reject noise on dry and wet sensors.                                */
+/* weight is the sensor height in half-sensors.                                         */
+static inline void LevelProcessSensor(uint8 index, uint32 weight, uint32 *activeCount, uint32 *levelSum)
+{
+    int32 count;
+    uint32 frac;
+    
+    levelReferenceRaw[index] = sensorFiltered[index];
+    count = LevelSaturate((int32)sensorFiltered[index] - sensorEmptyOffset[index]);
+    sensorDiff[index] = (int16)count;
+    
+    /* The saturated diff keeps the product within int32 for any scale */
+    count = LevelSaturate((count * sensorScale[index]) >> 8);
+    sensorProcessed[index] = (int16)count;
+    
+    if(count > (int32)sensorLimit)
+    {
+        *activeCount += weight;
+    }
+    
+    if(count > 0)
+    {
+        if(count > (int32)SENSORMAX)
+        {
+            count = SENSORMAX;
+        }
+        frac = ((uint32)count * LEVEL_FRAC_RECIP) >> 16;
+        if(frac >= LEVEL_FRAC_DEADBAND)
+        {
+            if(frac > (LEVEL_FRAC_FULL - LEVEL_FRAC_DEADBAND))
+            {
+                frac = LEVEL_FRAC_FULL;
+            }
+            *levelSum += frac * weight;
+        }
+    }
+}
+
+/*******************************************************************************
+* Function Name: LevelProcessFrame
+********************************************************************************/
+/* Calculate the liquid level from the current sensorFiltered frame in a single pass. */
+/* Offset removal, scaling, submerged threshold and height weighting are done per sensor,  */
+/* so each raw count is loaded once. The end sensors are peeled out of the loop because    */
+/* they are half the height of the middle sensors.                                        */
+/* Updates sensorDiff, sensorProcessed, sensorActiveCount, levelMmStep, levelMm and        */
+/* levelPercent. Levels are in fixed precision 24.8.                                      */
+void LevelProcessFrame(void)
+{
+    uint8 i;
+    uint32 activeCount = 0u;    /* Number of submerged half-sensors */
+    uint32 levelSum = 0u;       /* Sum of submerged half-sensors. Fixed precision 24.8 */
+    uint32 halfHeight = (uint32)(sensorHeight >> 1);
+    int32 level;
+    
+    LevelProcessSensor(0u, LEVEL_WEIGHT_END, &activeCount, &levelSum);
+    for(i = 1u; i < (NUMSENSORS - 1u); i++)
+    {
+        LevelProcessSensor(i, LEVEL_WEIGHT_MIDDLE, &activeCount, &levelSum);
+    }
+    LevelProcessSensor(NUMSENSORS - 1u, LEVEL_WEIGHT_END, &activeCount, &levelSum);
+    
+    sensorActiveCount = (uint8)activeCount;
+    
+    /* Calculate liquid level height in mm from the submerged sensor count */
+    level = (int32)(activeCount * halfHeight);
+    /* If level is near full value then round to full. Avoids fixed precision rounding errors */
+    if(level > ((int32)LEVELMM_MAX << 8) - (sensorHeight >> 2))
+    {
+        level = LEVELMM_MAX << 8;
+    }
+    levelMmStep = level;
+    
+    /* Calculate liquid level height in mm using the partial signal of the boundary sensor */
+    level = (int32)((levelSum * halfHeight) >> 8);
+    if(level > ((int32)LEVELMM_MAX << 8) - (int32)LEVEL_FULL_SNAP)
+    {
+        level = LEVELMM_MAX << 8;
+    }
+    levelMm = level;
+    
+    /* Calculate level percent. Stored in fixed precision 24.8 format to hold fractional percent */
+    levelPercent = LEVEL_MM_TO_PERCENT(level);
+}
+
+/*******************************************************************************
+* Function Name: LevelFrameChanged
+********************************************************************************/
+/* Check whether the current sensorFiltered frame needs processing.                     */
+/* Returns TRUE if any sensor has moved by more than LEVEL_CHANGE_HYSTERESIS counts     */
+/* since the last processed frame. Comparing against the last processed frame rather    */
+/* than the previous one means slow drift is still picked up once it adds up.           */
+uint8 LevelFrameChanged(void)
+{
+    uint8 i;
+    int32 delta;
+    
+    for(i = 0; i < NUMSENSORS; i++)
+    {
+        delta = (int32)sensorFiltered[i] - levelReferenceRaw[i];
+        if((delta > LEVEL_CHANGE_HYSTERESIS) || (delta < -LEVEL_CHANGE_HYSTERESIS))
+        {
+            return TRUE;
+        }
+    }
+    return FALSE;
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,73 @@
+/*****************************************************************************
+* File Name: level.h
+*
+* Version: 1.00
+*
+* Description: Liquid level estimation from normalized CapSense sensor counts.
+*
+* Related Document: Code example CE202479
+*
+* Hardware Dependency: See code example CE202479
+*
+******************************************************************************
+* Copyright (2015), Cypress Semiconductor Corporation.
+******************************************************************************
+* This software is owned by Cypress Semiconductor Corporation (Cypress) and is
+* protected by and subject to worldwide patent protection (United States and
+* foreign), United States copyright laws and international treaty provisions.
+* Cypress hereby grants to licensee a personal, non-exclusive, non-transferable
+* license to copy, use, modify, create derivative works of, and compile the
+* Cypress Source Code and derivative works for the sole purpose of creating
+* custom software in support of licensee product to be used only in conjunction
+* with a Cypress integrated circuit as specified in the applicable agreement.
+* Any reproduction, modification, translation, compilation, or representation of
+* this software except as specified above is prohibited without the express
+* written permission of Cypress.
+*
+* Disclaimer: CYPRESS MAKES NO WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, WITH
+* REGARD TO THIS MATERIAL, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+* Cypress reserves the right to make changes without further notice to the
+* materials described herein. Cypress does not assume any liability arising out
+* of the application or use of any product or circuit described herein. Cypress
+* does not authorize its products for use as critical components in life-support
+* systems where a malfunction or failure may reasonably be expected to result in
+* significant injury to the user. The inclusion of Cypress' product in a life-
+* support systems application implies that the manufacturer assumes all risk of
+* such use and in doing so indemnifies Cypress against all charges. Use may be
+* limited by and subject to the applicable Cypress software license agreement.
+*****************************************************************************/
+#if !defined(_LEVEL_H)
+#define _LEVEL_H
+    
+#include <project.h>
+#include <main.h>
+
+
+/* Function prototypes */
+void LevelInit(void);
+void LevelProcessFrame(void);
+uint8 LevelFrameChanged(void);
+
+/* Project Constants */
+/* Kernel constants */
+#define LEVEL_PROCESSED_MAX     (32767)         /* Saturation limits of the packed int16 diff and processed counts */
+#define LEVEL_PROCESSED_MIN     (-32768)
+/* Change detection constants */
+#define LEVEL_CHANGE_HYSTERESIS (3)             /* Raw count change of any sensor since the last processed frame that needs processing */
+#define LEVEL_FORCE_FRAMES      (100u)          /* A frame is processed at least this often even if nothing changed */
+/* Interpolation constants */
+#define LEVEL_FRAC_FULL         (256u)          /* Fully submerged sensor fraction. Fixed precision 24.8 */
+#define LEVEL_FRAC_RECIP        ((LEVEL_FRAC_FULL << 16) / SENSORMAX) /* 1 / SENSORMAX in fixed precision 16.16 to avoid a divide on Cortex-M0 */
+#define LEVEL_FRAC_DEADBAND     (16u)           /* Fractions within this band of empty or full are snapped to reject sensor noise */
+#define LEVEL_WEIGHT_END        (1u)            /* End sensors are one half-sensor tall */
+#define LEVEL_WEIGHT_MIDDLE     (2u)            /* Middle sensors are two half-sensors tall */
+#define LEVEL_FULL_SNAP         (1u << 8)       /* Levels within 1 mm of full are rounded to full. Fixed precision 24.8 */
+#define LEVEL_PERCENT_RECIP     (((100u << 16) + (LEVELMM_MAX / 2)) / LEVELMM_MAX) /* 100 / LEVELMM_MAX in fixed precision 16.16 */
+
+/* Convert level in mm to level percent. Both in fixed precision 24.8 */
+#define LEVEL_MM_TO_PERCENT(mm)     ((int32)(((uint32)(mm) * LEVEL_PERCENT_RECIP) >> 16))
+
+#endif /* _LEVEL_H */
+
+/* [] END OF FILE */
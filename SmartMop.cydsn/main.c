@@ -42,10 +42,23 @@
 #include "common_bmi270.h"
 #include "bmi270.h"
 #include <main.h>
+#include <level.h>
+#include <motion.h>
+#include <filter.h>
+#include <calibration.h>
+#include <estimator.h>
+#include <power.h>
+#include <scheduler.h>
+#include <ilo.h>
+#include <scan.h>
+#include <pipeline.h>
+#include <profile.h>
+#include <history.h>
+#include <notify.h>
+#include <stream.h>
 
 /*************************Macro Definitions**********************************/
-#define LED_DELAY_COUNT 0x32 //Counter value for LED Delay
-#define NOTIFICATION_DELAY_COUNT 0x20 //Counter value for Notification Delay
+#define LED_BLINK_PERIOD_MS 500u //Status LED toggle period while advertising
 /*****************************************************************************/
 
 /*****************************************************************************
@@ -77,47 +90,49 @@
 *  The timeout value is WDT_TIMEOUT_FAST_SCAN * SCANMODE_TIMEOUT_VALUE */
 #define SCANMODE_TIMEOUT_VALUE          (150u)  
 
-/* Finite state machine states for device operating states */
-typedef enum
-{
-    SENSOR_SCAN = 0x01u, /* Sensor is scanned in this state */
-    WAIT_FOR_SCAN_COMPLETE = 0x02u, /* CPU is put to sleep in this state */
-    PROCESS_DATA = 0x03u, /* Sensor data is processed */
-    BLE_PROCESS = 0x04u,
-    SLEEP = 0x05u /* Device is put to deep sleep */
-} DEVICE_STATE;
+/* Level change in percent that keeps the device in fast scan mode. Fixed precision 24.8 */
+#define SCANMODE_LEVEL_HYSTERESIS       (1u << 7)
+
+/* Scan modes */
+#define SCANMODE_FAST                   (0x00u)
+#define SCANMODE_SLOW                   (0x01u)
 
 /* Global variables */
-volatile uint8 wdtInterruptOccured = FALSE;
+uint8 scanRequested = FALSE;               /* Set by the scan task when the next frame is due */
+volatile uint8 bmi270InterruptOccured = FALSE;
 
 volatile uint32 watchdogMatchValue = WDT_TIMEOUT_FAST_SCAN;
+uint32 wdtMatchValFastMode = 0u;            /* Compensated Watchdog match value in fast scan mode */
+uint32 wdtMatchValSlowMode = 0u;            /* Compensated Watchdog match value in slow scan mode */
+volatile uint32 systemTimeMs = 0u;          /* Time since power-up in ms, advanced by the scheduler on every WDT interrupt */
+volatile uint32 scanIntervalMs = LOOP_TIME_FASTSCANMODE; /* Time between sensor scans in ms */
+uint8 scanMode = SCANMODE_FAST;             /* Current refresh rate */
+uint8 scanModeTimeoutCounter = SCANMODE_TIMEOUT_VALUE; /* Quiet fast scan frames left before switching to slow scan */
+int32 scanModeLevelPercent = 0u;            /* Level when the device last saw a level change. Fixed precision 24.8 */
 /* Global variables used because this is the method uProbe uses to access firmware data */
 /* CapSense tuning variables */
 uint8 modDac = SENSOR_MODDAC;               /* Modulation DAC current setting */
 uint8 compDac[NUMSENSORS] = {SENSOR_CMPDAC, SENSOR_CMPDAC, SENSOR_CMPDAC, SENSOR_CMPDAC, SENSOR_CMPDAC, SENSOR_CMPDAC, SENSOR_CMPDAC, SENSOR_CMPDAC, SENSOR_CMPDAC, SENSOR_CMPDAC, SENSOR_CMPDAC, SENSOR_CMPDAC}; /* Compensation DAC current setting */
 uint8 senseDivider = SENSOR_SENDIV;         /* Sensor clock divider */
 uint8 modDivider = SENSOR_MODDIV;           /* Modulation clock divider */
-uint8 NotificationDelayCounter = NOTIFICATION_DELAY_COUNT; //Counter to handle the periodic notification
-uint8 LEDDelayCounter = LED_DELAY_COUNT; //Counter to handle the LED blinking
 extern long LastCapSenseData;
 extern uint8 StartAdvertisement; //This flag is used to start advertisement
+extern uint8 BroadcastRestart; //This flag is used to restart the slow broadcast advertising
+extern uint8 BroadcastAdvertising; //Set while the slow broadcast advertising runs
+extern uint8 BroadcastStopping; //Set while the slow broadcast advertising stops to enter discoverable mode
 extern uint8 DeviceConnected; //This flag is set when a Central device is connected
 extern uint8 CapSenseNotificationEnabled; //This flag is set when the Central device writes to CCCD to enable temperature notification
 extern uint8 CapSenseNotificationData; //The temperature notification value is stored in this array
+extern uint8 motionSloshing;
+extern uint32 iloCounts;
+extern uint16 scanFrameMask;
+extern uint8 streamEnabled;
+extern uint16 sensorRaw[];
+extern int32 levelPercent;
 
 /* Liquid Level variables */
-int32 sensorRaw[NUMSENSORS] = {0u};         /* Sensor raw counts */
-int32 sensorDiff[NUMSENSORS] = {0u};        /* Sensor difference counts */
-int16 sensorEmptyOffset[NUMSENSORS] = {0u}; /* Sensor counts when empty to calculate diff counts. Loaded from EEPROM array */
-const int16 CYCODE eepromEmptyOffset[NUMSENSORS] = {0,1486,1864,2563,2680,1892,1905,1825,1904,2024,2086,884};/* Sensor counts when empty to calculate diff counts. Loaded from EEPROM array */
-int16 sensorScale[NUMSENSORS] = {0x01D0, 0x0100, 0x0100, 0x0100, 0x0100, 0x0100, 0x0100, 0x0100, 0x0100, 0x0100, 0x0100, 0x01C0}; /* Scaling factor to normalize sensor full scale counts. 0x0100 = 1.0 in fixed precision 8.8 */
-int32 sensorProcessed[NUMSENSORS] = {0u, 0u}; /* fixed precision 24.8 */
-uint16 sensorLimit = SENSORLIMIT;           /* Threshold for determining if a sensor is submerged. Set to half of SENSORMAX value */
-uint8 sensorActiveCount = 0u;               /* Number of sensors currently submerged */
+uint32 frameCount = 0u;                     /* Number of scanned frames */
 int32 previousLevelPercent = 0u;
-int32 levelPercent = 0u;                    /* fixed precision 24.8 */
-int32 levelMm = 0u;                         /* fixed precision 24.8 */   
-int32 sensorHeight = SENSORHEIGHT;          /* Height of a single sensor. Fixed precision 24.8 */
 /* This variable is used to generate required WDT interrupt period */ 
 uint32 ILODelayCycles = WDT_MATCH_VALUE_200MS;
 
@@ -136,6 +151,10 @@ void ReadSensorDataAndNotify(void);
 void HandleStatusLED(void);
 void WDT_Start(uint32 *wdtMatchValFastMode, uint32 *wdtMatchValSlowMode);
 uint32 CalibrateWdtMatchValue(void);
+void UpdateScanMode(uint32 wdtMatchValFastMode, uint32 wdtMatchValSlowMode);
+void SetScanMode(uint8 mode, uint32 matchValue);
+void HandleScan(void);
+void HandleIloCalibration(void);
 
 
 CY_ISR_PROTO(Pin_BMI270);
@@ -145,12 +164,6 @@ int main()
 {   
     InitializeSystem();
     
-    /* Compensated Watchdog match value in fast scan mode */
-    uint32 wdtMatchValFastMode = 0u;
-
-    /* Compensated Watchdog match value in slow scan mode */
-    uint32 wdtMatchValSlowMode = 0u;
-    
     /* Variable to store interrupt state */
     uint8 interruptState = 0u;
     
@@ -159,93 +172,118 @@ int main()
     */
     DEVICE_STATE currentState = SENSOR_SCAN; 
     
+    /* State the residency time is accounted to */
+    DEVICE_STATE accountedState = SENSOR_SCAN;
+    
     
      
     WDT_Start(&wdtMatchValFastMode, &wdtMatchValSlowMode);
     
+    /* Every periodic job is a scheduler task. The WDT wakes the device at the earliest deadline */
+    SchedulerRegister(SCHEDULER_TASK_SCAN, HandleScan);
+    SchedulerRegister(SCHEDULER_TASK_CONN, HandleConnectionUpdate);
+    SchedulerRegister(SCHEDULER_TASK_NOTIFY, HandleNotification);
+    SchedulerRegister(SCHEDULER_TASK_LED, HandleStatusLED);
+    SchedulerRegister(SCHEDULER_TASK_ILO, HandleIloCalibration);
+    SchedulerRegister(SCHEDULER_TASK_DIAG, PowerDiagnosticsUpdate);
+    SchedulerRegister(SCHEDULER_TASK_HISTORY, HistoryRecord);
+    SchedulerRegister(SCHEDULER_TASK_SYNC, HandleHistorySync);
+    SchedulerRegister(SCHEDULER_TASK_ESTIMATOR, EstimatorUpdate);
+    SchedulerStart(SCHEDULER_TASK_SCAN, LOOP_TIME_FASTSCANMODE, LOOP_TIME_FASTSCANMODE);
+    SchedulerStart(SCHEDULER_TASK_ILO, 0u, ILO_RECAL_PERIOD_MS); //Measure the ILO right away, then periodically
+    SchedulerStart(SCHEDULER_TASK_HISTORY, HISTORY_SAMPLE_PERIOD_MS, HISTORY_SAMPLE_PERIOD_MS);
+    SchedulerStart(SCHEDULER_TASK_ESTIMATOR, ESTIMATOR_SAMPLE_PERIOD_MS, ESTIMATOR_SAMPLE_PERIOD_MS);
+    
     while(1u)
     {
+        /* The BLE stack must be processed after every wakeup, BLESS events are not scheduled */
+        PROFILE_BEGIN(PROFILE_PROBE_BLE_STACK);
         CyBle_ProcessEvents();
-        HandleStatusLED();
+        PROFILE_END(PROFILE_PROBE_BLE_STACK);
+        
+        /* Hand the queued notifications to the stack while it has free buffers */
+        NotifyQueueDrain();
+        
+        /* Run the due tasks and program the WDT for the next deadline */
+        PROFILE_BEGIN(PROFILE_PROBE_SCHEDULER);
+        SchedulerRun();
+        PROFILE_END(PROFILE_PROBE_SCHEDULER);
+        
+        /* Residency and transition counts per state */
+        if(currentState != accountedState)
+        {
+            accountedState = currentState;
+            PowerStateEnter(currentState);
+        }
+        
         switch(currentState){
             case SENSOR_SCAN:
-                if(CapSense_CSD_IsBusy() == FALSE)
+                /* Collect the completed frame and start the next scan right away. The frame is
+                *  filtered, processed and notified while the hardware scans the next one */
+                PROFILE_BEGIN(PROFILE_PROBE_SCAN);
+                if(ScanCollect(sensorRaw))
                 {
-                    /* Read and store new sensor raw counts*/
-            	    for(i = 0; i < NUMSENSORS; i++)
-                    {
-            		  sensorRaw[i] = CapSense_CSD_ReadSensorRaw(i);
-            		  sensorDiff[i] = sensorRaw[i];
-            	    }
-
-            	  /* Start scan for next iteration */
-            	  CapSense_CSD_ScanEnabledWidgets();
-
-            	  //ProcessUart();
-                  currentState = WAIT_FOR_SCAN_COMPLETE;
-                  
+                    /* Start scan for next iteration. Only the sensors around the boundary between full sweeps */
+                    ScanStart();
+                    PROFILE_END(PROFILE_PROBE_SCAN);
+                    
+                    /* Nothing to process before the first scan completed */
+                    currentState = (scanFrameMask != 0u) ? PROCESS_DATA : BLE_PROCESS;
+                }
+                else
+                {
+                    /* The frame was due before the previous scan completed */
+                    PROFILE_END(PROFILE_PROBE_SCAN);
+                    currentState = WAIT_FOR_SCAN_COMPLETE;
                 }
                 break;
             case WAIT_FOR_SCAN_COMPLETE:
                 interruptState = CyEnterCriticalSection();
                 
                 /* Check if CapSense scanning is complete */
-                if(!CapSense_CSD_IsBusy())
+                if(CapSense_CSD_IsBusy())
                 {
-                    /* If CapSense scanning is in progress, put CPU to sleep */
+                    /* If CapSense scanning is in progress, put CPU to sleep until the CapSense interrupt */
                     CySysPmSleep();
                 }
-                /* If CapSense scanning is complete, process the CapSense data */
+                /* If CapSense scanning is complete, collect the frame */
                 else
                 {
-                    currentState = PROCESS_DATA;
+                    currentState = SENSOR_SCAN;
                 }
                 /* Enable interrupts for servicing ISR */
                 CyExitCriticalSection(interruptState);
                 break;
             case PROCESS_DATA:
+                frameCount++;
                 
-                   	
-            	  /* Remove empty offset calibration from sensor raw counts and normalize sensor full count values */
-            	  for(i = 0; i < NUMSENSORS; i++)
-            	  {
-            		  sensorDiff[i] -= sensorEmptyOffset[i];
-            		  sensorProcessed[i] = (sensorDiff[i] * sensorScale[i]) >> 8;
-            	  }
-            				
-            	  /* Find the number of submerged sensors */
-            	  sensorActiveCount = 0;
-            	  for(i = 0; i < NUMSENSORS; i++)
-            	  {
-            		  if(sensorProcessed[i] > sensorLimit)
-            		  {
-            			  /* First and last sensor are half the height of middle sensors */
-            			  if((i == 0) || (i == NUMSENSORS - 1))
-            			  {
-            				  sensorActiveCount += 1;
-            			  }
-            			  /* Middle sensors are twice the height of 1st and last sensors */
-            			  else
-            			  {
-            				  sensorActiveCount += 2;
-            			  }
-            		  }
-            	  }
-            	
-            	  /* Calculate liquid level height in mm */
-            	  levelMm = sensorActiveCount * (sensorHeight >> 1);
-            	  /* If level is near full value then round to full. Avoids fixed precision rounding errors */
-            	  if(levelMm > ((int32)LEVELMM_MAX << 8) - (sensorHeight >> 2))
-            	  {
-            		  levelMm = LEVELMM_MAX << 8;
-            	  }
-
-            	/* Calculate level percent. Stored in fixed precision 24.8 format to hold fractional percent */
-            	levelPercent = (levelMm * 100) / LEVELMM_MAX;
+                /* Filter the frame and calculate the level, unless no sensor moved */
+                if(PipelineProcessFrame())
+                {
+                    /* Correct the level for the tilt of the mop and hold level updates while the liquid is sloshing */
+                    PROFILE_BEGIN(PROFILE_PROBE_MOTION);
+                    MotionUpdate();
+                    MotionCompensateTilt();
+                    MotionGateLevel();
+                    PROFILE_END(PROFILE_PROBE_MOTION);
+                    
+                    /* Track drift of the empty offsets of dry sensors */
+                    PROFILE_BEGIN(PROFILE_PROBE_TRACKING);
+                    CalibrationTrackBaseline();
+                    
+                    /* Scale the sensors if full-tank scaling was requested */
+                    CalibrationProcessFullScale();
+                    PROFILE_END(PROFILE_PROBE_TRACKING);
+                }
             	
-            	/* Report level and process uProbe and UART interfaces */
+            	/* Report level and process uProbe and UART interfaces on every frame, also when it was skipped */
+                PROFILE_BEGIN(PROFILE_PROBE_INTERFACE);
             	ProcessUprobe();
+                ProcessUart();
+                PROFILE_END(PROFILE_PROBE_INTERFACE);
                 
+                /* Stream the raw, diff and processed counts of the frame */
+                StreamRecord();
                 
                 currentState = BLE_PROCESS;
         	   
@@ -255,51 +293,65 @@ int main()
                 currentState = SLEEP;
                 interruptState = CyEnterCriticalSection();
                 
-                if(StartAdvertisement)
+                if(StartAdvertisement && BroadcastAdvertising)
                 {
-                    StartAdvertisement = FALSE; //Clear the advertisement flag
-                    
-                    CyBle_GappStartAdvertisement(CYBLE_ADVERTISING_FAST); //Start advertisement and enter Discoverable mode
-                    
-                    LED_Write(ZERO); //Turn on the status LED
-                    LED_SetDriveMode(LED_DM_STRONG); //Set the LED pin drive mode to Strong
-                    
+                    /* The slow broadcast is running. Stop it first, the flag stays set until
+                    *  CYBLE_EVT_GAPP_ADVERTISEMENT_START_STOP reports the advertising stopped */
+                    if(!BroadcastStopping)
+                    {
+                        CyBle_GappStopAdvertisement();
+                        BroadcastStopping = TRUE;
+                    }
                 }
-        
-                if(DeviceConnected)
+                else if(StartAdvertisement && !BroadcastStopping)
                 {
+                    StartAdvertisement = FALSE; //Clear the advertisement flag
                     
-                    UpdateConnectionParameters();
-                    UpdateNotificationCCCDAttribute();
-                    
-                    
-                    if(CapSenseNotificationEnabled)
+                    /* Start advertisement and enter Discoverable mode. Nothing to do when already connected or discoverable */
+                    if((CyBle_GetState() == CYBLE_STATE_DISCONNECTED) &&
+                        (CyBle_GappStartAdvertisement(CYBLE_ADVERTISING_FAST) == CYBLE_ERROR_OK))
                     {
-                    
-                        if(previousLevelPercent != levelPercent)
-                        {
-                            previousLevelPercent = levelPercent;
-                            SendCapSenseNotification(levelPercent>>8);
-                        }
+                        BroadcastRestart = FALSE; //The broadcast resumes after the advertising timeout
                         
+                        LED_Write(ZERO); //Turn on the status LED
+                        LED_SetDriveMode(LED_DM_STRONG); //Set the LED pin drive mode to Strong
                         
+                        SchedulerStart(SCHEDULER_TASK_LED, LED_BLINK_PERIOD_MS, LED_BLINK_PERIOD_MS); //Blink while advertising
                     }
+                }
+                else if(BroadcastRestart && (CyBle_GetState() == CYBLE_STATE_DISCONNECTED))
+                {
+                    BroadcastRestart = FALSE;
                     
-                    
-                    
+                    /* Keep the level readable by scanners while no Central device is connected */
+                    if(CyBle_GappStartAdvertisement(CYBLE_ADVERTISING_SLOW) == CYBLE_ERROR_OK)
+                    {
+                        BroadcastAdvertising = TRUE;
+                    }
                 }
+                
+                /* Refresh the level in the advertising data and schedule the level notification */
+                UpdateBroadcastData();
+                UpdateLevelNotification();
+                
+                /* Connection parameters and level notifications are handled by scheduler tasks */
                 CyExitCriticalSection(interruptState);
+                
+                /* Choose the refresh rate for the next frame */
+                UpdateScanMode(wdtMatchValFastMode, wdtMatchValSlowMode);
                 break;
             
             case SLEEP:
-                CySysPmSleep();
+                /* Enter DeepSleep when the BLE stack and CapSense allow it, else Sleep */
+                PowerManagerSleep();
                 
-                if(wdtInterruptOccured)
+                /* Tasks run at the top of the loop. Scan when the scan task was due */
+                if(scanRequested)
                 {
                     /* Set state to scan sensor after device wakes up from sleep */
                     currentState = SENSOR_SCAN;
                     
-                    wdtInterruptOccured = FALSE;  
+                    scanRequested = FALSE;  
                 }
                 
                 break;
@@ -323,16 +375,20 @@ void InitializeSystem(void)
 	 * function exposes the events from BLE component for application use */
     CyBle_Start(CustomEventHandler);
     
-    /* Read stored empty offset values from EEPROM */
-    for(uint8 i = 0; i < NUMSENSORS; i++)
-    {
-        sensorEmptyOffset[i] = eepromEmptyOffset[i];
-    }
+    /* Read stored empty offset and scale values from EEPROM */
+    LevelInit();
+    
+    /* Allocate the raw count filter history */
+    FilterInit();
+    
+    /* Start tracking the empty offsets from the stored values */
+    CalibrationInit();
     	
 	/* ADD_CODE to initialize CapSense component and initialize baselines*/
 	CapSense_CSD_Start();
 	CapSense_CSD_ScanEnabledWidgets();
     I2C_Start();
+    UART_Start(); //UART commands of ProcessUart and the profiler dump
     
     rslt = bmi2_interface_init(&bmi2_dev, BMI2_I2C_INTF);
     
@@ -365,12 +421,21 @@ void InitializeSystem(void)
     }
     
     BMI270_Interrupt_StartEx(Pin_BMI270);
+    
+    #if defined(LEVEL_BENCHMARK_ENABLED) || defined(PROFILE_ENABLED)
+        /* Free running SysTick used as a cycle counter. The interrupt is not needed */
+        CySysTickStart();
+        CySysTickDisableInterrupt();
+        CySysTickSetReload(LEVEL_BENCHMARK_SYSTICK_MASK);
+        CySysTickClear();
+    #endif /* LEVEL_BENCHMARK_ENABLED || PROFILE_ENABLED */
 }
 
 /*************************************************************************************************************************
 * Function Name: HandleStatusLED
 **************************************************************************************************************************
-* Summary: This function controls the status LED depending upon the BLE state.
+* Summary: Scheduler task that controls the status LED depending upon the BLE state. It runs
+* every LED_BLINK_PERIOD_MS while advertising and stops itself when advertising ends.
 *
 * Parameters:
 *  void
@@ -381,19 +446,16 @@ void InitializeSystem(void)
 *************************************************************************************************************************/
 void HandleStatusLED(void)
 {
-    /* Check whether the device is advertising and blink the LED */
-    if(CyBle_GetState() == CYBLE_STATE_ADVERTISING)
+    /* Check whether the device is advertising in discoverable mode and blink the LED */
+    if((CyBle_GetState() == CYBLE_STATE_ADVERTISING) && !BroadcastAdvertising)
     {
-        if(--LEDDelayCounter == ZERO)
-        {
-            LEDDelayCounter = LED_DELAY_COUNT; //Reset the LED state counter
-            LED_Write(!LED_Read()); //Toggle the status LED when the counter is reset
-        }
+        LED_Write(!LED_Read()); //Toggle the status LED
     }    
     else
     {
         LED_Write(ONE); //Turn off the status LED
         LED_SetDriveMode(LED_DM_ALG_HIZ); //Set the LED pin drive mode to Hi-Z
+        SchedulerStop(SCHEDULER_TASK_LED);
     }
 }
 
@@ -405,6 +467,8 @@ CY_ISR(Pin_BMI270)
     BMI270_Interrupt_ClearPending();    
     Pin_BMI270_ClearInterrupt();
     StartAdvertisement = TRUE;
+    bmi270InterruptOccured = TRUE;
+    ScanRequestFullSweep();
 }
 
 /******************************************************************************
@@ -414,7 +478,7 @@ CY_ISR(Pin_BMI270)
 *  The main function performs the following actions:
 *   1. Clears the interrupt
 *   2. The WDT match value is updated depending on the device
-*   3. Flag is set to indicate that WDT interrupt was triggered
+*   3. The scheduler time base is advanced by the WDT period
 *
 * Parameters:
 *  None.
@@ -436,8 +500,9 @@ CY_ISR(Timer_Interrupt)
         CySysWdtWriteMatch(CySysWdtReadMatch() + watchdogMatchValue); 
     #endif /* !CY_IP_SRSSV2 */
     
-    /* Set to variable that indicates that WDT interrupt had triggered*/
-    wdtInterruptOccured = TRUE;   
+    /* Advance the scheduler time and systemTimeMs by the WDT period. The tasks */
+    /* run from the main loop after the wakeup                                  */
+    SchedulerTimerInterrupt();
 }
 
 /******************************************************************************
@@ -470,8 +535,8 @@ void WDT_Start(uint32 *wdtMatchValFastMode, uint32 *wdtMatchValSlowMode)
     *wdtMatchValFastMode = CalibrateWdtMatchValue();
     
     #if (CY_IP_SRSSV2)    
-        /* Configure Match value */
-        CySysWdtWriteMatch(CY_SYS_WDT_COUNTER0, *wdtMatchValSlowMode);
+        /* Configure Match value. The device starts in fast scan mode */
+        CySysWdtWriteMatch(CY_SYS_WDT_COUNTER0, *wdtMatchValFastMode);
         
         /* Set up WDT mode */
         CySysWdtSetMode(CY_SYS_WDT_COUNTER0, CY_SYS_WDT_MODE_INT);
@@ -490,6 +555,9 @@ void WDT_Start(uint32 *wdtMatchValFastMode, uint32 *wdtMatchValSlowMode)
         CySysWdtUnmaskInterrupt();
         
     #endif
+    
+    /* Convert between ms and ILO ticks with the calibrated slow scan period */
+    SchedulerInit(*wdtMatchValSlowMode, LOOP_TIME_SLOWSCANMODE);
 }
 
 /*******************************************************************************
@@ -524,5 +592,156 @@ uint32 CalibrateWdtMatchValue(void)
     }
     return watchdogMatchValue;
 }
+/*******************************************************************************
+* Function Name: UpdateScanMode
+********************************************************************************
+* Summary:
+*  Switches between fast and slow scan mode:
+*   1. Any level change, BMI270 interrupt, new BLE connection or the raw sensor
+*      stream selects fast scan
+*   2. SCANMODE_TIMEOUT_VALUE fast scan frames without level change or motion
+*      select slow scan
+*
+* Parameters:
+*  wdtMatchValFastMode: Compensated WDT match value in fast scan mode
+*  wdtMatchValSlowMode: Compensated WDT match value in slow scan mode
+*
+* Return:
+*  None.
+*
+*******************************************************************************/
+void UpdateScanMode(uint32 wdtMatchValFastMode, uint32 wdtMatchValSlowMode)
+{
+    static uint8 wasConnected = FALSE;
+    uint8 activity = FALSE;
+    int32 levelChange = levelPercent - scanModeLevelPercent;
+    
+    if((levelChange > (int32)SCANMODE_LEVEL_HYSTERESIS) || (levelChange < -(int32)SCANMODE_LEVEL_HYSTERESIS))
+    {
+        scanModeLevelPercent = levelPercent;
+        activity = TRUE;
+    }
+    if(bmi270InterruptOccured)
+    {
+        bmi270InterruptOccured = FALSE;
+        activity = TRUE;
+    }
+    if(DeviceConnected && !wasConnected)
+    {
+        activity = TRUE;
+    }
+    wasConnected = DeviceConnected;
+    if(motionSloshing || streamEnabled)
+    {
+        activity = TRUE;
+    }
+    
+    if(activity)
+    {
+        scanModeTimeoutCounter = SCANMODE_TIMEOUT_VALUE;
+        if(scanMode != SCANMODE_FAST)
+        {
+            SetScanMode(SCANMODE_FAST, wdtMatchValFastMode);
+        }
+    }
+    else if(scanMode == SCANMODE_FAST)
+    {
+        if(--scanModeTimeoutCounter == 0u)
+        {
+            SetScanMode(SCANMODE_SLOW, wdtMatchValSlowMode);
+        }
+    }
+}
+
+/*******************************************************************************
+* Function Name: SetScanMode
+********************************************************************************
+* Summary:
+*  Changes the period of the scan task to the refresh interval of the given
+*  scan mode. The next scan is one new interval from now. On devices with a
+*  clear-on-match WDT counter the scheduler moves the WDT match, on other
+*  devices the WDT keeps interrupting at the scan mode period.
+*
+* Parameters:
+*  mode: SCANMODE_FAST or SCANMODE_SLOW
+*  matchValue: Compensated WDT match value for the mode
+*
+* Return:
+*  None.
+*
+*******************************************************************************/
+void SetScanMode(uint8 mode, uint32 matchValue)
+{
+    uint8 interruptState = CyEnterCriticalSection();
+    
+    scanMode = mode;
+    scanIntervalMs = (mode == SCANMODE_FAST) ? LOOP_TIME_FASTSCANMODE : LOOP_TIME_SLOWSCANMODE;
+    watchdogMatchValue = matchValue;
+    
+    CyExitCriticalSection(interruptState);
+    
+    SchedulerStart(SCHEDULER_TASK_SCAN, scanIntervalMs, scanIntervalMs);
+}
+
+/*******************************************************************************
+* Function Name: HandleScan
+********************************************************************************
+* Summary:
+*  Scheduler task that requests the next sensor scan. The scan itself runs in
+*  the SENSOR_SCAN state once the state machine is back in SLEEP.
+*
+* Parameters:
+*  None.
+*
+* Return:
+*  None.
+*
+*******************************************************************************/
+void HandleScan(void)
+{
+    scanRequested = TRUE;
+}
+
+/*******************************************************************************
+* Function Name: HandleIloCalibration
+********************************************************************************
+* Summary:
+*  Scheduler task that measures the ILO against the IMO every
+*  ILO_RECAL_PERIOD_MS. The ILO drifts with temperature over a shift, so after
+*  every measurement the scheduler tick rate and both scan mode match values
+*  are updated. The match values and watchdogMatchValue change together in a
+*  critical section, the WDT interrupt never sees a mix of old and new values
+*  and the current scan mode keeps its period.
+*
+* Parameters:
+*  None.
+*
+* Return:
+*  None.
+*
+*******************************************************************************/
+void HandleIloCalibration(void)
+{
+    uint8 interruptState;
+    uint32 fastMatch;
+    uint32 slowMatch;
+    
+    if(IloServiceRun() != ILO_DONE)
+    {
+        return;
+    }
+    
+    fastMatch = IloMatchValue(LOOP_TIME_FASTSCANMODE);
+    slowMatch = IloMatchValue(LOOP_TIME_SLOWSCANMODE);
+    
+    interruptState = CyEnterCriticalSection();
+    
+    wdtMatchValFastMode = fastMatch;
+    wdtMatchValSlowMode = slowMatch;
+    watchdogMatchValue = (scanMode == SCANMODE_FAST) ? fastMatch : slowMatch;
+    SchedulerSetRate(iloCounts, ILO_REFERENCE_MS);
+    
+    CyExitCriticalSection(interruptState);
+}
 /* [] END OF FILE */
 
@@ -37,6 +37,9 @@
 * such use and in doing so indemnifies Cypress against all charges. Use may be
 * limited by and subject to the applicable Cypress software license agreement.
 *****************************************************************************/
+#if !defined(_MAIN_H)
+#define _MAIN_H
+    
 #include <project.h>
 #include <BLEApplications.h>
 #include "CyFlash.h"
@@ -62,6 +65,10 @@ cystatus Em_EEPROM_Write(const uint8 srcBuf[], const uint8 eepromPtr[], uint32 b
 *****************************************************************************/
 #define CAPSENSE_ENABLED
 #define BLE_ENABLED
+//#define LEVEL_BENCHMARK_ENABLED       /* Measure FilterProcessFrame and LevelProcessFrame CPU cycles with SysTick */
+//#define PROFILE_ENABLED               /* Record the hot paths in the profiler trace with SysTick, dumped by the UART 'P' command */
+
+#define LEVEL_BENCHMARK_SYSTICK_MASK    (0x00FFFFFFu) /* SysTick is a 24 bit down counter */
 
 #define RED_INDEX						(0)
 #define GREEN_INDEX						(1)
@@ -82,6 +89,17 @@ cystatus Em_EEPROM_Write(const uint8 srcBuf[], const uint8 eepromPtr[], uint32 b
 #define Em_EEPROM_FLASH_END_ADDR         (Em_EEPROM_FLASH_BASE_ADDR + Em_EEPROM_FLASH_SIZE)
 #define Em_EEPROM_ROWS_IN_ARRAY          (CY_FLASH_SIZEOF_ARRAY/CY_FLASH_SIZEOF_ROW)
 
+/* Finite state machine states for device operating states */
+typedef enum
+{
+    SENSOR_SCAN = 0x01u, /* The completed frame is collected and the next scan is started in this state */
+    WAIT_FOR_SCAN_COMPLETE = 0x02u, /* CPU is put to sleep in this state when a frame is due before the previous scan completed */
+    PROCESS_DATA = 0x03u, /* Sensor data is processed while the next frame is scanned */
+    BLE_PROCESS = 0x04u,
+    SLEEP = 0x05u /* Device is put to deep sleep */
+} DEVICE_STATE;
+#define DEVICE_STATE_COUNT  (0x06u)        /* States are numbered from 1 */
+
 /* Adjust WDT time */
 #define WDT_MATCH_VALUE_30MS		(32 * 30) //30ms (IL0~32K)
 #define WDT_MATCH_VALUE_200MS		(32 * 200) //200ms (IL0~32K)
@@ -89,4 +107,6 @@ cystatus Em_EEPROM_Write(const uint8 srcBuf[], const uint8 eepromPtr[], uint32 b
 #define SLEEP_30MS 0x01
 #define SLEEP_200MS 0x02
 
+#endif /* _MAIN_H */
+
 /* [] END OF FILE */
@@ -0,0 +1,269 @@
+/*****************************************************************************
+* File Name: motion.c
+*
+* Version: 1.00
+*
+* Description: Motion processing of BMI270 accelerometer data for the level pipeline.
+*
+* Related Document: Code example CE202479
+*
+* Hardware Dependency: See code example CE202479
+*
+******************************************************************************
+* Copyright (2015), Cypress Semiconductor Corporation.
+******************************************************************************
+* This software is owned by Cypress Semiconductor Corporation (Cypress) and is
+* protected by and subject to worldwide patent protection (United States and
+* foreign), United States copyright laws and international treaty provisions.
+* Cypress hereby grants to licensee a personal, non-exclusive, non-transferable
+* license to copy, use, modify, create derivative works of, and compile the
+* Cypress Source Code and derivative works for the sole purpose of creating
+* custom software in support of licensee product to be used only in conjunction
+* with a Cypress integrated circuit as specified in the applicable agreement.
+* Any reproduction, modification, translation, compilation, or representation of
+* this software except as specified above is prohibited without the express
+* written permission of Cypress.
+*
+* Disclaimer: CYPRESS MAKES NO WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, WITH
+* REGARD TO THIS MATERIAL, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+* Cypress reserves the right to make changes without further notice to the
+* materials described herein. Cypress does not assume any liability arising out
+* of the application or use of any product or circuit described herein. Cypress
+* does not authorize its products for use as critical components in life-support
+* systems where a malfunction or failure may reasonably be expected to result in
+* significant injury to the user. The inclusion of Cypress' product in a life-
+* support systems application implies that the manufacturer assumes all risk of
+* such use and in doing so indemnifies Cypress against all charges. Use may be
+* limited by and subject to the applicable Cypress software license agreement.
+*****************************************************************************/
+#include <project.h>
+#include <main.h>
+#include <level.h>
+#include <motion.h>
+#include "bmi2.h"
+
+
+/* Global variables */
+/* Global variables used because this is the method uProbe uses to access firmware data */
+int32 motionMean[MOTION_AXES] = {0, 0, 0}; /* Running mean of each axis. Scaled by 2^MOTION_MEAN_SHIFT */
+uint32 motionVariance = 0u;                 /* Running variance summed over all axes */
+uint8 motionSloshing = FALSE;               /* Set while level updates are held because of slosh */
+uint8 motionSettleCount = 0u;               /* Quiet frames remaining before level updates are released */
+int32 levelMmHeld = 0u;                     /* Level published while sloshing. Fixed precision 24.8 */
+int32 motionTilt = 0;                       /* Tilt of the tank, positive when the ladder side is raised. Fixed precision 24.8 degrees */
+int32 tiltLadderOffset = MOTION_LADDER_OFFSET_MM << 8; /* Distance of the electrode ladder from the tank centre. Fixed precision 24.8 */
+int32 levelMmUncompensated = 0u;            /* Level measured along the electrode ladder. Fixed precision 24.8 */
+/* External globals */
+extern struct bmi2_dev bmi2_dev;
+extern int32 levelMm;
+extern int32 levelPercent;
+
+/* atan(k / 32) for k = 0..32. Fixed precision 24.8 degrees */
+static const int16 CYCODE motionAtanTable[MOTION_ATAN_TABLE_SIZE] = {
+    0, 458, 916, 1371, 1824, 2273, 2719, 3159, 3593, 4021, 4443, 4856, 5262, 5660, 6049, 6429,
+    6801, 7163, 7516, 7859, 8193, 8518, 8834, 9141, 9439, 9728, 10008, 10280, 10544, 10799, 11047, 11287,
+    11520};
+/* tan(5 * k degrees) for k = 0..14. Fixed precision 24.8 */
+static const int16 CYCODE motionTanTable[MOTION_TAN_TABLE_SIZE] = {
+    0, 22, 45, 69, 93, 119, 148, 179, 215, 256, 305, 366, 443, 549, 703};
+
+/* Static variables */
+static struct bmi2_sens_data motionData;
+static uint8 motionMeanValid = FALSE;      /* Cleared until the running mean is seeded with the first sample */
+
+
+/*******************************************************************************
+* Function Name: MotionUpdate
+********************************************************************************/
+/* Read the accelerometer and update the running mean and variance of acceleration.    */
+/* The liquid is treated as sloshing while the variance is over MOTION_SLOSH_THRESHOLD  */
+/* and for MOTION_SETTLE_FRAMES quiet frames afterwards.                                */
+void MotionUpdate(void)
+{
+    uint8 i;
+    int32 sample[MOTION_AXES];
+    int32 deviation;
+    uint32 variance = 0u;
+    
+    if(bmi2_get_sensor_data(&motionData, &bmi2_dev) != BMI2_OK)
+    {
+        return;
+    }
+    sample[0] = motionData.acc.x;
+    sample[1] = motionData.acc.y;
+    sample[2] = motionData.acc.z;
+    
+    /* Seed the running mean so that the orientation at power-up is not seen as motion */
+    if(!motionMeanValid)
+    {
+        for(i = 0; i < MOTION_AXES; i++)
+        {
+            motionMean[i] = sample[i] << MOTION_MEAN_SHIFT;
+        }
+        motionMeanValid = TRUE;
+    }
+    
+    for(i = 0; i < MOTION_AXES; i++)
+    {
+        motionMean[i] += sample[i] - (motionMean[i] >> MOTION_MEAN_SHIFT);
+        deviation = (sample[i] - (motionMean[i] >> MOTION_MEAN_SHIFT)) >> MOTION_DEV_SHIFT;
+        variance += (uint32)(deviation * deviation);
+    }
+    motionVariance += (variance >> MOTION_VAR_SHIFT) - (motionVariance >> MOTION_VAR_SHIFT);
+    
+    if(motionVariance > MOTION_SLOSH_THRESHOLD)
+    {
+        motionSettleCount = MOTION_SETTLE_FRAMES;
+    }
+    else if(motionSettleCount > 0u)
+    {
+        motionSettleCount--;
+    }
+    motionSloshing = (motionSettleCount > 0u) ? TRUE : FALSE;
+}
+
+/*******************************************************************************
+* Function Name: MotionGateLevel
+********************************************************************************/
+/* Hold the published level while the liquid is sloshing.                              */
+/* The held level slowly follows the measured level so that a long mopping session      */
+/* still tracks consumption, and snaps to the measured level once the liquid settles.   */
+/* Updates levelMm and levelPercent.                                                    */
+void MotionGateLevel(void)
+{
+    if(motionSloshing)
+    {
+        levelMmHeld += (levelMm - levelMmHeld) >> MOTION_SLOSH_LEVEL_SHIFT;
+        levelMm = levelMmHeld;
+        levelPercent = LEVEL_MM_TO_PERCENT(levelMm);
+    }
+    else
+    {
+        levelMmHeld = levelMm;
+    }
+}
+
+/*******************************************************************************
+* Function Name: MotionAtan
+********************************************************************************/
+/* Return atan(num / den) in fixed precision 24.8 degrees for 0 <= num <= den.          */
+/* The table is indexed by the ratio in steps of 1/32 and linearly interpolated.        */
+static int32 MotionAtan(uint32 num, uint32 den)
+{
+    uint32 ratio;
+    uint32 index;
+    uint32 frac;
+    
+    if(den == 0u)
+    {
+        return 0;
+    }
+    /* Ratio in fixed precision 24.8 */
+    ratio = (num << 8) / den;
+    index = ratio >> 3;
+    frac = ratio & 0x07u;
+    if(index >= (MOTION_ATAN_TABLE_SIZE - 1u))
+    {
+        return motionAtanTable[MOTION_ATAN_TABLE_SIZE - 1u];
+    }
+    return motionAtanTable[index] + (int32)(((motionAtanTable[index + 1u] - motionAtanTable[index]) * frac) >> 3);
+}
+
+/*******************************************************************************
+* Function Name: MotionTan
+********************************************************************************/
+/* Return tan(angle) in fixed precision 24.8 for an angle in fixed precision 24.8        */
+/* degrees. The table is in steps of MOTION_TAN_TABLE_STEP and linearly interpolated.   */
+/* The angle must be within +/- MOTION_TILT_MAX.                                        */
+static int32 MotionTan(int32 angle)
+{
+    uint32 magnitude = (uint32)((angle < 0) ? -angle : angle);
+    uint32 index = magnitude / (MOTION_TAN_TABLE_STEP << 8);
+    uint32 frac = magnitude - (index * (MOTION_TAN_TABLE_STEP << 8));
+    int32 result;
+    
+    if(index >= (MOTION_TAN_TABLE_SIZE - 1u))
+    {
+        result = motionTanTable[MOTION_TAN_TABLE_SIZE - 1u];
+    }
+    else
+    {
+        result = motionTanTable[index] + (int32)(((motionTanTable[index + 1u] - motionTanTable[index]) * frac) / (MOTION_TAN_TABLE_STEP << 8));
+    }
+    return (angle < 0) ? -result : result;
+}
+
+/*******************************************************************************
+* Function Name: MotionCompensateTilt
+********************************************************************************/
+/* Correct the level measured along the electrode ladder to the level the tank would    */
+/* show upright. The liquid surface stays horizontal, so with the ladder mounted        */
+/* tiltLadderOffset away from the tank centre the ladder reads offset * tan(tilt) less  */
+/* when its side of the tank is raised and more when it is lowered. The volume of       */
+/* liquid, and so the upright level, follows the reading at the tank centre.            */
+/* The tilt is taken from the running mean of gravity. Beyond MOTION_TILT_MAX the       */
+/* reading is not trusted and the previous compensated level is kept. Until the BMI270  */
+/* delivered a first sample, e.g. when it failed to start, the level is not compensated. */
+/* Updates motionTilt, levelMm and levelPercent.                                        */
+void MotionCompensateTilt(void)
+{
+    static int32 levelMmCompensated = 0;
+    static uint8 levelMmCompensatedValid = FALSE;
+    int32 across = motionMean[MOTION_TILT_AXIS] >> MOTION_MEAN_SHIFT;
+    int32 along = motionMean[MOTION_LADDER_AXIS] >> MOTION_MEAN_SHIFT;
+    uint32 acrossMag = (uint32)((across < 0) ? -across : across);
+    int32 level;
+    
+    levelMmUncompensated = levelMm;
+    
+    if(!motionMeanValid)
+    {
+        return;
+    }
+    
+    /* Tilt is the angle of gravity from the ladder axis in the plane of the ladder offset */
+    if(along <= 0)
+    {
+        /* Lying flat or upside down */
+        motionTilt = (across < 0) ? -(90 << 8) : (90 << 8);
+    }
+    else if(acrossMag <= (uint32)along)
+    {
+        motionTilt = MotionAtan(acrossMag, (uint32)along);
+    }
+    else
+    {
+        motionTilt = (90 << 8) - MotionAtan((uint32)along, acrossMag);
+    }
+    if((across < 0) && (along > 0))
+    {
+        motionTilt = -motionTilt;
+    }
+    
+    if((motionTilt > MOTION_TILT_MAX) || (motionTilt < -MOTION_TILT_MAX))
+    {
+        if(levelMmCompensatedValid)
+        {
+            levelMm = levelMmCompensated;
+        }
+    }
+    else
+    {
+        level = levelMm + ((tiltLadderOffset * MotionTan(motionTilt)) >> 8);
+        if(level < 0)
+        {
+            level = 0;
+        }
+        if(level > ((int32)LEVELMM_MAX << 8))
+        {
+            level = LEVELMM_MAX << 8;
+        }
+        levelMm = level;
+        levelMmCompensated = level;
+        levelMmCompensatedValid = TRUE;
+    }
+    levelPercent = LEVEL_MM_TO_PERCENT(levelMm);
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,74 @@
+/*****************************************************************************
+* File Name: motion.h
+*
+* Version: 1.00
+*
+* Description: Motion processing of BMI270 accelerometer data for the level pipeline.
+*
+* Related Document: Code example CE202479
+*
+* Hardware Dependency: See code example CE202479
+*
+******************************************************************************
+* Copyright (2015), Cypress Semiconductor Corporation.
+******************************************************************************
+* This software is owned by Cypress Semiconductor Corporation (Cypress) and is
+* protected by and subject to worldwide patent protection (United States and
+* foreign), United States copyright laws and international treaty provisions.
+* Cypress hereby grants to licensee a personal, non-exclusive, non-transferable
+* license to copy, use, modify, create derivative works of, and compile the
+* Cypress Source Code and derivative works for the sole purpose of creating
+* custom software in support of licensee product to be used only in conjunction
+* with a Cypress integrated circuit as specified in the applicable agreement.
+* Any reproduction, modification, translation, compilation, or representation of
+* this software except as specified above is prohibited without the express
+* written permission of Cypress.
+*
+* Disclaimer: CYPRESS MAKES NO WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, WITH
+* REGARD TO THIS MATERIAL, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+* Cypress reserves the right to make changes without further notice to the
+* materials described herein. Cypress does not assume any liability arising out
+* of the application or use of any product or circuit described herein. Cypress
+* does not authorize its products for use as critical components in life-support
+* systems where a malfunction or failure may reasonably be expected to result in
+* significant injury to the user. The inclusion of Cypress' product in a life-
+* support systems application implies that the manufacturer assumes all risk of
+* such use and in doing so indemnifies Cypress against all charges. Use may be
+* limited by and subject to the applicable Cypress software license agreement.
+*****************************************************************************/
+#if !defined(_MOTION_H)
+#define _MOTION_H
+    
+#include <project.h>
+
+
+/* Function prototypes */
+void MotionUpdate(void);
+void MotionGateLevel(void);
+void MotionCompensateTilt(void);
+
+/* Project Constants */
+/* Accelerometer constants */
+#define MOTION_AXES                 (3u)            /* x, y and z */
+#define MOTION_ACCEL_1G             (4096)          /* Accelerometer counts per g at the BMI270 default range of +/-8 g */
+/* Slosh detection constants */
+#define MOTION_MEAN_SHIFT           (3u)            /* Filter weight 1/8 for the running mean of each axis */
+#define MOTION_VAR_SHIFT            (3u)            /* Filter weight 1/8 for the running variance */
+#define MOTION_DEV_SHIFT            (4u)            /* Deviation from the mean is scaled down before squaring to stay in 32 bits */
+#define MOTION_SLOSH_THRESHOLD      (160u)          /* Summed axis variance above which the liquid is sloshing (~0.05 g RMS) */
+#define MOTION_SETTLE_FRAMES        (100u)          /* Quiet frames before level updates are released (1 s in fast scan mode) */
+#define MOTION_SLOSH_LEVEL_SHIFT    (5u)            /* Filter weight 1/32 for the level while it is held during slosh */
+
+/* Tilt compensation constants */
+#define MOTION_TILT_AXIS            (0u)            /* Accelerometer axis pointing from the tank centre towards the electrode ladder */
+#define MOTION_LADDER_AXIS          (2u)            /* Accelerometer axis pointing up along the electrode ladder */
+#define MOTION_LADDER_OFFSET_MM     (20u)           /* Distance of the electrode ladder from the tank centre in mm */
+#define MOTION_ATAN_TABLE_SIZE      (33u)           /* atan() table entries for ratios 0..1 in steps of 1/32 */
+#define MOTION_TAN_TABLE_SIZE       (15u)           /* tan() table entries for 0..70 degrees in steps of 5 degrees */
+#define MOTION_TAN_TABLE_STEP       (5u)            /* Degrees between tan() table entries */
+#define MOTION_TILT_MAX             ((int32)((MOTION_TAN_TABLE_SIZE - 1u) * MOTION_TAN_TABLE_STEP) << 8) /* Tilt beyond which the level is not updated. Fixed precision 24.8 degrees */
+
+#endif /* _MOTION_H */
+
+/* [] END OF FILE */
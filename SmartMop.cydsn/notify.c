@@ -0,0 +1,226 @@
+/*****************************************************************************
+* File Name: notify.c
+*
+* Version: 1.00
+*
+* Description: Bounded outbound notification queue drained when the BLE stack has free buffers.
+*
+* Related Document: Code example CE202479
+*
+* Hardware Dependency: See code example CE202479
+*
+******************************************************************************
+* Copyright (2015), Cypress Semiconductor Corporation.
+******************************************************************************
+* This software is owned by Cypress Semiconductor Corporation (Cypress) and is
+* protected by and subject to worldwide patent protection (United States and
+* foreign), United States copyright laws and international treaty provisions.
+* Cypress hereby grants to licensee a personal, non-exclusive, non-transferable
+* license to copy, use, modify, create derivative works of, and compile the
+* Cypress Source Code and derivative works for the sole purpose of creating
+* custom software in support of licensee product to be used only in conjunction
+* with a Cypress integrated circuit as specified in the applicable agreement.
+* Any reproduction, modification, translation, compilation, or representation of
+* this software except as specified above is prohibited without the express
+* written permission of Cypress.
+*
+* Disclaimer: CYPRESS MAKES NO WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, WITH
+* REGARD TO THIS MATERIAL, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+* Cypress reserves the right to make changes without further notice to the
+* materials described herein. Cypress does not assume any liability arising out
+* of the application or use of any product or circuit described herein. Cypress
+* does not authorize its products for use as critical components in life-support
+* systems where a malfunction or failure may reasonably be expected to result in
+* significant injury to the user. The inclusion of Cypress' product in a life-
+* support systems application implies that the manufacturer assumes all risk of
+* such use and in doing so indemnifies Cypress against all charges. Use may be
+* limited by and subject to the applicable Cypress software license agreement.
+*****************************************************************************/
+#include <project.h>
+#include <main.h>
+#include <notify.h>
+#include <string.h>
+
+
+/* Global variables */
+/* Global variables used because this is the method uProbe uses to access firmware data */
+uint32 notifyQueueQueued = 0u;              /* Notifications added to the queue */
+uint32 notifyQueueSent = 0u;                /* Notifications accepted by the stack */
+uint32 notifyQueueDropped = 0u;             /* Notifications lost because the queue was full, the link closed or the stack refused them */
+uint32 notifyQueueCoalesced = 0u;           /* Notifications replaced by a newer value before they were sent */
+uint8 notifyQueueHighWater = 0u;            /* Most notifications waiting at the same time */
+/* External globals */
+extern uint8 DeviceConnected;
+extern uint8 BLEStackStatus;
+
+/* Static variables */
+static NOTIFY_QUEUE_ENTRY notifyQueue[NOTIFY_QUEUE_DEPTH];
+static volatile uint8 notifyQueueHead = 0u; /* Next entry sent */
+static volatile uint8 notifyQueueCount = 0u; /* Entries waiting */
+
+
+/*******************************************************************************
+* Function Name: NotifyQueuePut
+********************************************************************************/
+/* Queue a notification of length bytes for handle. Can be called from an        */
+/* interrupt. With coalesce set, a queued value of the same handle that also      */
+/* allows coalescing is replaced, so only the latest level waits in the queue.    */
+/* The head entry is never replaced, the stack may be copying it. Returns FALSE   */
+/* and counts a drop when the queue is full or the value is too long. send, if    */
+/* not NULL, can still change the value before the stack gets it. done, if not    */
+/* NULL, learns whether the stack accepted the notification. With coalesce, it    */
+/* runs only for the value that leaves the queue, a replaced value is not         */
+/* reported.                                                                      */
+uint8 NotifyQueuePut(uint16 handle, const uint8 data[], uint16 length, uint8 coalesce, NOTIFY_SEND_HANDLER send, NOTIFY_DONE_HANDLER done)
+{
+    NOTIFY_QUEUE_ENTRY *entry = NULL;
+    uint8 i;
+    uint8 index;
+    uint8 result = TRUE;
+    uint8 interruptState;
+    
+    interruptState = CyEnterCriticalSection();
+    
+    if(coalesce)
+    {
+        for(i = 1u; i < notifyQueueCount; i++)
+        {
+            index = (notifyQueueHead + i) % NOTIFY_QUEUE_DEPTH;
+            if(notifyQueue[index].coalesce && (notifyQueue[index].handle == handle))
+            {
+                entry = &notifyQueue[index];
+                notifyQueueCoalesced++;
+                break;
+            }
+        }
+    }
+    
+    if(length > NOTIFY_QUEUE_DATA_LEN)
+    {
+        result = FALSE;
+    }
+    else if(entry == NULL)
+    {
+        if(notifyQueueCount < NOTIFY_QUEUE_DEPTH)
+        {
+            entry = &notifyQueue[(notifyQueueHead + notifyQueueCount) % NOTIFY_QUEUE_DEPTH];
+            notifyQueueCount++;
+            if(notifyQueueCount > notifyQueueHighWater)
+            {
+                notifyQueueHighWater = notifyQueueCount;
+            }
+        }
+        else
+        {
+            result = FALSE;
+        }
+    }
+    
+    if(result)
+    {
+        entry->handle = handle;
+        entry->length = length;
+        entry->coalesce = coalesce;
+        entry->send = send;
+        entry->done = done;
+        memcpy(entry->data, data, length);
+        notifyQueueQueued++;
+    }
+    else
+    {
+        notifyQueueDropped++;
+    }
+    
+    CyExitCriticalSection(interruptState);
+    return result;
+}
+
+/*******************************************************************************
+* Function Name: NotifyQueueDrain
+********************************************************************************/
+/* Hand queued notifications to the stack, oldest first, while it reports free   */
+/* buffers. Called from the main loop after CyBle_ProcessEvents, which delivers  */
+/* CYBLE_EVT_STACK_BUSY_STATUS. A notification the stack is too busy for stays   */
+/* queued, any other error drops it. The send handler runs before every attempt, */
+/* the done handler before the entry is released.                                */
+void NotifyQueueDrain(void)
+{
+    CYBLE_GATTS_HANDLE_VALUE_NTF_T notification;
+    CYBLE_API_RESULT_T status;
+    NOTIFY_QUEUE_ENTRY *entry;
+    uint8 interruptState;
+    
+    while((notifyQueueCount > 0u) && DeviceConnected && (BLEStackStatus == CYBLE_STACK_STATE_FREE) &&
+        (CyBle_GattGetBusStatus() == CYBLE_STACK_STATE_FREE))
+    {
+        entry = &notifyQueue[notifyQueueHead];
+        if(entry->send != NULL)
+        {
+            entry->send(entry->data);
+        }
+        notification.attrHandle = entry->handle;
+        notification.value.val = entry->data;
+        notification.value.len = entry->length;
+        
+        status = CyBle_GattsNotification(cyBle_connHandle, &notification);
+        if(status == CYBLE_ERROR_INSUFFICIENT_RESOURCES)
+        {
+            break;
+        }
+        
+        if(status == CYBLE_ERROR_OK)
+        {
+            notifyQueueSent++;
+        }
+        else
+        {
+            notifyQueueDropped++;
+        }
+        if(entry->done != NULL)
+        {
+            entry->done(entry->data, (status == CYBLE_ERROR_OK));
+        }
+        interruptState = CyEnterCriticalSection();
+        notifyQueueHead = (notifyQueueHead + 1u) % NOTIFY_QUEUE_DEPTH;
+        notifyQueueCount--;
+        CyExitCriticalSection(interruptState);
+    }
+}
+
+/*******************************************************************************
+* Function Name: NotifyQueueClear
+********************************************************************************/
+/* Drop every queued notification, on disconnect. The done handlers learn that */
+/* their notifications were not sent.                                          */
+void NotifyQueueClear(void)
+{
+    NOTIFY_QUEUE_ENTRY *entry;
+    uint8 interruptState;
+    uint8 i;
+    
+    interruptState = CyEnterCriticalSection();
+    for(i = 0u; i < notifyQueueCount; i++)
+    {
+        entry = &notifyQueue[(notifyQueueHead + i) % NOTIFY_QUEUE_DEPTH];
+        if(entry->done != NULL)
+        {
+            entry->done(entry->data, FALSE);
+        }
+    }
+    notifyQueueDropped += notifyQueueCount;
+    notifyQueueHead = 0u;
+    notifyQueueCount = 0u;
+    CyExitCriticalSection(interruptState);
+}
+
+/*******************************************************************************
+* Function Name: NotifyQueueSpace
+********************************************************************************/
+/* Number of free queue entries. */
+uint8 NotifyQueueSpace(void)
+{
+    return NOTIFY_QUEUE_DEPTH - notifyQueueCount;
+}
+
+/* [] END OF FILE */
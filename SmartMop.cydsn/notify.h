@@ -0,0 +1,76 @@
+/*****************************************************************************
+* File Name: notify.h
+*
+* Version: 1.00
+*
+* Description: Bounded outbound notification queue drained when the BLE stack has free buffers.
+*
+* Related Document: Code example CE202479
+*
+* Hardware Dependency: See code example CE202479
+*
+******************************************************************************
+* Copyright (2015), Cypress Semiconductor Corporation.
+******************************************************************************
+* This software is owned by Cypress Semiconductor Corporation (Cypress) and is
+* protected by and subject to worldwide patent protection (United States and
+* foreign), United States copyright laws and international treaty provisions.
+* Cypress hereby grants to licensee a personal, non-exclusive, non-transferable
+* license to copy, use, modify, create derivative works of, and compile the
+* Cypress Source Code and derivative works for the sole purpose of creating
+* custom software in support of licensee product to be used only in conjunction
+* with a Cypress integrated circuit as specified in the applicable agreement.
+* Any reproduction, modification, translation, compilation, or representation of
+* this software except as specified above is prohibited without the express
+* written permission of Cypress.
+*
+* Disclaimer: CYPRESS MAKES NO WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, WITH
+* REGARD TO THIS MATERIAL, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+* Cypress reserves the right to make changes without further notice to the
+* materials described herein. Cypress does not assume any liability arising out
+* of the application or use of any product or circuit described herein. Cypress
+* does not authorize its products for use as critical components in life-support
+* systems where a malfunction or failure may reasonably be expected to result in
+* significant injury to the user. The inclusion of Cypress' product in a life-
+* support systems application implies that the manufacturer assumes all risk of
+* such use and in doing so indemnifies Cypress against all charges. Use may be
+* limited by and subject to the applicable Cypress software license agreement.
+*****************************************************************************/
+#if !defined(_NOTIFY_H)
+#define _NOTIFY_H
+    
+#include <project.h>
+#include <main.h>
+
+
+/* Called with the value of a queued notification right before it is handed to the stack, e.g. to stamp a sequence number */
+typedef void (*NOTIFY_SEND_HANDLER)(uint8 data[]);
+/* Called with the value of a queued notification once the stack accepted it, sent TRUE, or once it was dropped */
+typedef void (*NOTIFY_DONE_HANDLER)(const uint8 data[], uint8 sent);
+
+/* Function prototypes */
+uint8 NotifyQueuePut(uint16 handle, const uint8 data[], uint16 length, uint8 coalesce, NOTIFY_SEND_HANDLER send, NOTIFY_DONE_HANDLER done);
+void NotifyQueueDrain(void);
+void NotifyQueueClear(void);
+uint8 NotifyQueueSpace(void);
+
+/* Project Constants */
+#define NOTIFY_QUEUE_DEPTH          (8u)            /* Notifications waiting for the stack */
+#define NOTIFY_QUEUE_DATA_LEN       (MTU_XCHANGE_DATA_LEN - NOTIFICATION_HEADER_LEN) /* Largest notification value */
+#define NOTIFY_QUEUE_RESERVED       (2u)            /* Entries bulk streams leave free for level notifications */
+
+/* Notification waiting for the stack */
+typedef struct
+{
+    uint16 handle;                          /* Characteristic value handle */
+    uint16 length;                          /* Bytes in data */
+    uint8 coalesce;                         /* A newer value of the same handle replaces this one */
+    NOTIFY_SEND_HANDLER send;               /* Called before each attempt to send, or NULL */
+    NOTIFY_DONE_HANDLER done;               /* Called when the notification leaves the queue, or NULL */
+    uint8 data[NOTIFY_QUEUE_DATA_LEN];
+} NOTIFY_QUEUE_ENTRY;
+
+#endif /* _NOTIFY_H */
+
+/* [] END OF FILE */
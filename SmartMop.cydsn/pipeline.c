@@ -0,0 +1,126 @@
+/*****************************************************************************
+* File Name: pipeline.c
+*
+* Version: 1.00
+*
+* Description: Front end of the PROCESS_DATA state: filtering, frame skipping and the level kernel.
+*
+* Related Document: Code example CE202479
+*
+* Hardware Dependency: See code example CE202479
+*
+******************************************************************************
+* Copyright (2015), Cypress Semiconductor Corporation.
+******************************************************************************
+* This software is owned by Cypress Semiconductor Corporation (Cypress) and is
+* protected by and subject to worldwide patent protection (United States and
+* foreign), United States copyright laws and international treaty provisions.
+* Cypress hereby grants to licensee a personal, non-exclusive, non-transferable
+* license to copy, use, modify, create derivative works of, and compile the
+* Cypress Source Code and derivative works for the sole purpose of creating
+* custom software in support of licensee product to be used only in conjunction
+* with a Cypress integrated circuit as specified in the applicable agreement.
+* Any reproduction, modification, translation, compilation, or representation of
+* this software except as specified above is prohibited without the express
+* written permission of Cypress.
+*
+* Disclaimer: CYPRESS MAKES NO WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, WITH
+* REGARD TO THIS MATERIAL, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+* Cypress reserves the right to make changes without further notice to the
+* materials described herein. Cypress does not assume any liability arising out
+* of the application or use of any product or circuit described herein. Cypress
+* does not authorize its products for use as critical components in life-support
+* systems where a malfunction or failure may reasonably be expected to result in
+* significant injury to the user. The inclusion of Cypress' product in a life-
+* support systems application implies that the manufacturer assumes all risk of
+* such use and in doing so indemnifies Cypress against all charges. Use may be
+* limited by and subject to the applicable Cypress software license agreement.
+*****************************************************************************/
+#include <project.h>
+#include <main.h>
+#include <pipeline.h>
+#include <filter.h>
+#include <level.h>
+#include <calibration.h>
+#include <profile.h>
+
+
+/* Global variables */
+/* Global variables used because this is the method uProbe uses to access firmware data */
+uint32 frameSkipCount = 0u;                 /* Number of frames not processed because no sensor changed */
+uint8 frameForceCounter = LEVEL_FORCE_FRAMES; /* Frames left until a frame is processed even if no sensor changed */
+#if defined(LEVEL_BENCHMARK_ENABLED)
+uint32 levelKernelCycles = 0u;              /* CPU cycles spent in LevelProcessFrame for the last frame */
+uint32 levelKernelCyclesMax = 0u;           /* Worst case CPU cycles spent in LevelProcessFrame */
+uint32 filterCycles = 0u;                   /* CPU cycles spent in FilterProcessFrame for the last frame */
+uint32 filterCyclesMax = 0u;                /* Worst case CPU cycles spent in FilterProcessFrame */
+#endif /* LEVEL_BENCHMARK_ENABLED */
+/* External globals */
+extern uint16 sensorRaw[];
+extern uint16 sensorFiltered[];
+extern uint16 scanFrameMask;
+extern uint8 motionSloshing;
+extern uint8 calScaleState;
+
+
+/*******************************************************************************
+* Function Name: PipelineProcessFrame
+********************************************************************************/
+/* Filter the frame collected by ScanCollect and calculate the level. The level  */
+/* is skipped when no sensor moved. Frames are still processed while the liquid  */
+/* settles, during full-tank scaling and every LEVEL_FORCE_FRAMES frames so that */
+/* baseline tracking and the consumption estimate keep running. Shared with the  */
+/* host simulator. Returns FALSE when the frame was skipped.                     */
+uint8 PipelineProcessFrame(void)
+{
+    #if defined(LEVEL_BENCHMARK_ENABLED)
+        filterCycles = CySysTickGetValue();
+    #endif /* LEVEL_BENCHMARK_ENABLED */
+    
+    /* Remove noise from the raw counts before they are processed */
+    PROFILE_BEGIN(PROFILE_PROBE_FILTER);
+    FilterProcessFrame(sensorRaw, sensorFiltered, scanFrameMask);
+    PROFILE_END(PROFILE_PROBE_FILTER);
+    
+    #if defined(LEVEL_BENCHMARK_ENABLED)
+        /* SysTick counts down */
+        filterCycles = (filterCycles - CySysTickGetValue()) & LEVEL_BENCHMARK_SYSTICK_MASK;
+        if(filterCycles > filterCyclesMax)
+        {
+            filterCyclesMax = filterCycles;
+        }
+    #endif /* LEVEL_BENCHMARK_ENABLED */
+    
+    if(--frameForceCounter == 0u)
+    {
+        frameForceCounter = LEVEL_FORCE_FRAMES;
+    }
+    else if(!LevelFrameChanged() && !motionSloshing && (calScaleState != CAL_SCALE_RUNNING))
+    {
+        frameSkipCount++;
+        return FALSE;
+    }
+    
+    #if defined(LEVEL_BENCHMARK_ENABLED)
+        levelKernelCycles = CySysTickGetValue();
+    #endif /* LEVEL_BENCHMARK_ENABLED */
+    
+    /* Remove empty offset, normalize, find the submerged sensors and calculate the level in one pass */
+    PROFILE_BEGIN(PROFILE_PROBE_LEVEL);
+    LevelProcessFrame();
+    PROFILE_END(PROFILE_PROBE_LEVEL);
+    
+    #if defined(LEVEL_BENCHMARK_ENABLED)
+        /* SysTick counts down */
+        levelKernelCycles = (levelKernelCycles - CySysTickGetValue()) & LEVEL_BENCHMARK_SYSTICK_MASK;
+        if(levelKernelCycles > levelKernelCyclesMax)
+        {
+            levelKernelCyclesMax = levelKernelCycles;
+        }
+    #endif /* LEVEL_BENCHMARK_ENABLED */
+    
+    return TRUE;
+}
+
+/* [] END OF FILE */
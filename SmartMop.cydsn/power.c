@@ -0,0 +1,198 @@
+/*****************************************************************************
+* File Name: power.c
+*
+* Version: 1.00
+*
+* Description: Low power mode selection for the SLEEP state.
+*
+* Related Document: Code example CE202479
+*
+* Hardware Dependency: See code example CE202479
+*
+******************************************************************************
+* Copyright (2015), Cypress Semiconductor Corporation.
+******************************************************************************
+* This software is owned by Cypress Semiconductor Corporation (Cypress) and is
+* protected by and subject to worldwide patent protection (United States and
+* foreign), United States copyright laws and international treaty provisions.
+* Cypress hereby grants to licensee a personal, non-exclusive, non-transferable
+* license to copy, use, modify, create derivative works of, and compile the
+* Cypress Source Code and derivative works for the sole purpose of creating
+* custom software in support of licensee product to be used only in conjunction
+* with a Cypress integrated circuit as specified in the applicable agreement.
+* Any reproduction, modification, translation, compilation, or representation of
+* this software except as specified above is prohibited without the express
+* written permission of Cypress.
+*
+* Disclaimer: CYPRESS MAKES NO WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, WITH
+* REGARD TO THIS MATERIAL, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+* Cypress reserves the right to make changes without further notice to the
+* materials described herein. Cypress does not assume any liability arising out
+* of the application or use of any product or circuit described herein. Cypress
+* does not authorize its products for use as critical components in life-support
+* systems where a malfunction or failure may reasonably be expected to result in
+* significant injury to the user. The inclusion of Cypress' product in a life-
+* support systems application implies that the manufacturer assumes all risk of
+* such use and in doing so indemnifies Cypress against all charges. Use may be
+* limited by and subject to the applicable Cypress software license agreement.
+*****************************************************************************/
+#include <project.h>
+#include <main.h>
+#include <power.h>
+#include <scheduler.h>
+
+
+/* Global variables */
+/* Global variables used because this is the method uProbe uses to access firmware data */
+uint32 powerSleepDepthCount[POWER_DEPTH_COUNT] = {0u}; /* Number of wakeups from each sleep depth */
+uint8 powerLastDepth = POWER_DEPTH_ACTIVE;  /* Sleep depth of the last wakeup */
+uint8 powerBatteryPercent = POWER_BATTERY_UNKNOWN; /* Battery level reported in the level notification */
+uint32 powerDepthTicks[POWER_DEPTH_COUNT] = {0u}; /* ILO ticks spent in PowerManagerSleep at each sleep depth */
+uint32 powerStateTicks[DEVICE_STATE_COUNT] = {0u}; /* ILO ticks spent in each DEVICE_STATE */
+uint16 powerStateEntries[DEVICE_STATE_COUNT] = {0u}; /* Number of transitions into each DEVICE_STATE */
+/* External globals */
+extern uint8 DeviceConnected;
+extern uint32 schedulerTicksPerMs;
+extern uint8 iloMeasuring;
+extern int32 iloErrorPpm;
+extern int32 iloErrorMinPpm;
+extern int32 iloErrorMaxPpm;
+extern uint16 iloMeasureCount;
+
+/* Static variables */
+static uint8 powerState = SENSOR_SCAN;      /* State the time is being accounted to */
+static uint32 powerStateStart = 0u;         /* Ticks when powerState was entered */
+
+
+/*******************************************************************************
+* Function Name: PowerManagerSleep
+********************************************************************************/
+/* Put the device into the deepest low power mode that is safe right now.                */
+/* The BLE subsystem is asked to enter DeepSleep first. DeepSleep is entered only when   */
+/* BLESS is in DeepSleep or is waiting for the ECO to start, no CapSense scan or ILO      */
+/* measurement is running and the UART has finished sending. If BLESS is still active the CPU only sleeps, and   */
+/* while BLESS is closing a connection event the CPU stays active.                        */
+/* The sleep depth of every wakeup is counted in powerSleepDepthCount.                    */
+void PowerManagerSleep(void)
+{
+    uint8 interruptState;
+    CYBLE_BLESS_STATE_T blessState;
+    uint8 depth = POWER_DEPTH_ACTIVE;
+    uint32 start = SchedulerNowTicks();
+    
+    CyBle_EnterLPM(CYBLE_BLESS_DEEPSLEEP);
+    
+    interruptState = CyEnterCriticalSection();
+    blessState = CyBle_GetBleSsState();
+    
+    if((blessState == CYBLE_BLESS_STATE_ECO_ON) || (blessState == CYBLE_BLESS_STATE_DEEPSLEEP))
+    {
+        if(!CapSense_CSD_IsBusy() && !iloMeasuring && (UART_SpiUartGetTxBufferSize() == 0u))
+        {
+            /* Save the configuration of components that lose it in DeepSleep */
+            CapSense_CSD_Sleep();
+            UART_Sleep();
+            I2C_Sleep();
+            
+            CySysPmDeepSleep();
+            
+            I2C_Wakeup();
+            UART_Wakeup();
+            CapSense_CSD_Wakeup();
+            depth = POWER_DEPTH_DEEPSLEEP;
+        }
+        else
+        {
+            CySysPmSleep();
+            depth = POWER_DEPTH_SLEEP;
+        }
+    }
+    else if(blessState != CYBLE_BLESS_STATE_EVENT_CLOSE)
+    {
+        CySysPmSleep();
+        depth = POWER_DEPTH_SLEEP;
+    }
+    
+    CyExitCriticalSection(interruptState);
+    
+    powerLastDepth = depth;
+    powerSleepDepthCount[depth]++;
+    powerDepthTicks[depth] += SchedulerNowTicks() - start;
+}
+
+/*******************************************************************************
+* Function Name: PowerStateEnter
+********************************************************************************/
+/* Account the time since the last transition to the state that is left and count */
+/* the entry into the new state. The time base is the scheduler ILO tick, which    */
+/* keeps running in DeepSleep. Call only when the state changes.                   */
+void PowerStateEnter(uint8 state)
+{
+    uint32 now = SchedulerNowTicks();
+    
+    powerStateTicks[powerState] += now - powerStateStart;
+    powerStateStart = now;
+    powerState = state;
+    powerStateEntries[state]++;
+}
+
+/*******************************************************************************
+* Function Name: PowerPack32
+********************************************************************************/
+/* Write a 32 bit value little endian. */
+static void PowerPack32(uint8 field[], uint32 value)
+{
+    field[0] = LO8(LO16(value));
+    field[1] = HI8(LO16(value));
+    field[2] = LO8(HI16(value));
+    field[3] = HI8(HI16(value));
+}
+
+/*******************************************************************************
+* Function Name: PowerDiagnosticsPack
+********************************************************************************/
+/* Write the residency counters and the ILO error to buffer as described by the    */
+/* POWER_DIAG offsets. The counters are free running and wrap, the host uses the    */
+/* difference between two records.                                                 */
+void PowerDiagnosticsPack(uint8 buffer[])
+{
+    uint8 i;
+    
+    PowerPack32(&buffer[POWER_DIAG_TICK_RATE], schedulerTicksPerMs);
+    
+    for(i = 0u; i < POWER_DIAG_STATES; i++)
+    {
+        PowerPack32(&buffer[POWER_DIAG_STATE_TICKS + (4u * i)], powerStateTicks[SENSOR_SCAN + i]);
+        buffer[POWER_DIAG_ENTRIES + (2u * i)] = LO8(powerStateEntries[SENSOR_SCAN + i]);
+        buffer[POWER_DIAG_ENTRIES + (2u * i) + 1u] = HI8(powerStateEntries[SENSOR_SCAN + i]);
+    }
+    
+    for(i = 0u; i < POWER_DEPTH_COUNT; i++)
+    {
+        PowerPack32(&buffer[POWER_DIAG_DEPTH_TICKS + (4u * i)], powerDepthTicks[i]);
+    }
+    
+    PowerPack32(&buffer[POWER_DIAG_ILO_ERROR], (uint32)iloErrorPpm);
+    PowerPack32(&buffer[POWER_DIAG_ILO_ERROR + 4u], (uint32)iloErrorMinPpm);
+    PowerPack32(&buffer[POWER_DIAG_ILO_ERROR + 8u], (uint32)iloErrorMaxPpm);
+    buffer[POWER_DIAG_ILO_MEASURES] = LO8(iloMeasureCount);
+    buffer[POWER_DIAG_ILO_MEASURES + 1u] = HI8(iloMeasureCount);
+}
+
+/*******************************************************************************
+* Function Name: PowerDiagnosticsUpdate
+********************************************************************************/
+/* Scheduler task that refreshes the diagnostics characteristic while connected. */
+void PowerDiagnosticsUpdate(void)
+{
+    uint8 record[POWER_DIAG_LEN];
+    
+    if(DeviceConnected)
+    {
+        PowerDiagnosticsPack(record);
+        UpdateDiagnosticsAttribute(record);
+    }
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,74 @@
+/*****************************************************************************
+* File Name: power.h
+*
+* Version: 1.00
+*
+* Description: Low power mode selection for the SLEEP state.
+*
+* Related Document: Code example CE202479
+*
+* Hardware Dependency: See code example CE202479
+*
+******************************************************************************
+* Copyright (2015), Cypress Semiconductor Corporation.
+******************************************************************************
+* This software is owned by Cypress Semiconductor Corporation (Cypress) and is
+* protected by and subject to worldwide patent protection (United States and
+* foreign), United States copyright laws and international treaty provisions.
+* Cypress hereby grants to licensee a personal, non-exclusive, non-transferable
+* license to copy, use, modify, create derivative works of, and compile the
+* Cypress Source Code and derivative works for the sole purpose of creating
+* custom software in support of licensee product to be used only in conjunction
+* with a Cypress integrated circuit as specified in the applicable agreement.
+* Any reproduction, modification, translation, compilation, or representation of
+* this software except as specified above is prohibited without the express
+* written permission of Cypress.
+*
+* Disclaimer: CYPRESS MAKES NO WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, WITH
+* REGARD TO THIS MATERIAL, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+* Cypress reserves the right to make changes without further notice to the
+* materials described herein. Cypress does not assume any liability arising out
+* of the application or use of any product or circuit described herein. Cypress
+* does not authorize its products for use as critical components in life-support
+* systems where a malfunction or failure may reasonably be expected to result in
+* significant injury to the user. The inclusion of Cypress' product in a life-
+* support systems application implies that the manufacturer assumes all risk of
+* such use and in doing so indemnifies Cypress against all charges. Use may be
+* limited by and subject to the applicable Cypress software license agreement.
+*****************************************************************************/
+#if !defined(_POWER_H)
+#define _POWER_H
+    
+#include <project.h>
+
+
+/* Function prototypes */
+void PowerManagerSleep(void);
+void PowerStateEnter(uint8 state);
+void PowerDiagnosticsPack(uint8 buffer[]);
+void PowerDiagnosticsUpdate(void);
+
+/* Project Constants */
+/* Sleep depth of a wakeup, index into powerSleepDepthCount */
+#define POWER_DEPTH_ACTIVE      (0u)            /* Stayed active, the BLE stack was closing a connection event */
+#define POWER_DEPTH_SLEEP       (1u)            /* CPU Sleep, HFCLK kept running */
+#define POWER_DEPTH_DEEPSLEEP   (2u)            /* DeepSleep, woken by WDT, BLESS or BMI270 pin interrupt */
+#define POWER_DEPTH_COUNT       (3u)
+
+#define POWER_BATTERY_UNKNOWN   (0xFFu)         /* powerBatteryPercent until a battery measurement is available */
+
+/* Residency diagnostics record, little endian, sent over BLE and UART */
+#define POWER_DIAG_PERIOD_MS    (10000u)        /* Diagnostics characteristic refresh period while connected */
+#define POWER_DIAG_STATES       (5u)            /* SENSOR_SCAN to SLEEP */
+#define POWER_DIAG_TICK_RATE    (0u)            /* uint32 ILO ticks per ms, fixed precision 24.8 */
+#define POWER_DIAG_STATE_TICKS  (4u)            /* uint32 ILO ticks spent in each state */
+#define POWER_DIAG_DEPTH_TICKS  (POWER_DIAG_STATE_TICKS + (4u * POWER_DIAG_STATES)) /* uint32 ILO ticks in each sleep depth */
+#define POWER_DIAG_ENTRIES      (POWER_DIAG_DEPTH_TICKS + (4u * POWER_DEPTH_COUNT)) /* uint16 entries into each state */
+#define POWER_DIAG_ILO_ERROR    (POWER_DIAG_ENTRIES + (2u * POWER_DIAG_STATES)) /* int32 ILO error in ppm: last, lowest, highest */
+#define POWER_DIAG_ILO_MEASURES (POWER_DIAG_ILO_ERROR + 12u) /* uint16 completed ILO measurements */
+#define POWER_DIAG_LEN          (POWER_DIAG_ILO_MEASURES + 2u)
+
+#endif /* _POWER_H */
+
+/* [] END OF FILE */
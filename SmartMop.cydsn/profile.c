@@ -0,0 +1,240 @@
+/*****************************************************************************
+* File Name: profile.c
+*
+* Version: 1.00
+*
+* Description: Hot-path cycle profiler with a trace ring buffer.
+*
+* Related Document: Code example CE202479
+*
+* Hardware Dependency: See code example CE202479
+*
+******************************************************************************
+* Copyright (2015), Cypress Semiconductor Corporation.
+******************************************************************************
+* This software is owned by Cypress Semiconductor Corporation (Cypress) and is
+* protected by and subject to worldwide patent protection (United States and
+* foreign), United States copyright laws and international treaty provisions.
+* Cypress hereby grants to licensee a personal, non-exclusive, non-transferable
+* license to copy, use, modify, create derivative works of, and compile the
+* Cypress Source Code and derivative works for the sole purpose of creating
+* custom software in support of licensee product to be used only in conjunction
+* with a Cypress integrated circuit as specified in the applicable agreement.
+* Any reproduction, modification, translation, compilation, or representation of
+* this software except as specified above is prohibited without the express
+* written permission of Cypress.
+*
+* Disclaimer: CYPRESS MAKES NO WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, WITH
+* REGARD TO THIS MATERIAL, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+* Cypress reserves the right to make changes without further notice to the
+* materials described herein. Cypress does not assume any liability arising out
+* of the application or use of any product or circuit described herein. Cypress
+* does not authorize its products for use as critical components in life-support
+* systems where a malfunction or failure may reasonably be expected to result in
+* significant injury to the user. The inclusion of Cypress' product in a life-
+* support systems application implies that the manufacturer assumes all risk of
+* such use and in doing so indemnifies Cypress against all charges. Use may be
+* limited by and subject to the applicable Cypress software license agreement.
+*****************************************************************************/
+#include <project.h>
+#include <main.h>
+#include <profile.h>
+
+#if defined(PROFILE_ENABLED)
+
+/* Global variables */
+/* Global variables used because this is the method uProbe uses to access firmware data */
+uint32 profileCount[PROFILE_PROBE_COUNT] = {0u};  /* Completed begin/end pairs of each probe */
+uint32 profileMin[PROFILE_PROBE_COUNT] = {0u};    /* Shortest time between begin and end in cycles */
+uint32 profileMax[PROFILE_PROBE_COUNT] = {0u};    /* Longest time between begin and end in cycles */
+uint64 profileSum[PROFILE_PROBE_COUNT] = {0u};    /* Total time between begin and end in cycles, for the mean */
+uint16 profileHistogram[PROFILE_PROBE_COUNT][PROFILE_HIST_BINS] = {{0u}}; /* Latency histogram, saturating */
+uint8 profileRecording = TRUE;                    /* Cleared while the trace is dumped */
+
+/* Static variables */
+static uint32 profileRing[PROFILE_RING_SIZE];     /* Trace events, see PROFILE_EVENT_PROBE_SHIFT */
+static uint16 profileRingHead = 0u;               /* Next event written */
+static uint16 profileRingCount = 0u;              /* Events in the ring */
+static uint32 profileBeginStamp[PROFILE_PROBE_COUNT]; /* Stamp of the open begin event of each probe */
+static uint16 profileOpenMask = 0u;               /* Probes with an open begin event */
+static uint16 profileChecksum;                    /* Sum of the bytes dumped so far */
+
+
+/*******************************************************************************
+* Function Name: ProfileEvent
+********************************************************************************/
+/* Record a begin or end event of a probe in the trace ring and, on the end event, */
+/* add the cycles since the begin event to the statistics of the probe. Called by  */
+/* PROFILE_BEGIN and PROFILE_END only. SysTick counts down, the stamp counts up.   */
+/* SysTick stops in DeepSleep, so a probe spanning DeepSleep only counts the       */
+/* active cycles. A probe must not be nested in itself.                            */
+void ProfileEvent(uint8 probe, uint8 type)
+{
+    uint32 stamp;
+    uint32 cycles;
+    uint16 bit = (uint16)(1u << probe);
+    uint8 bin;
+    uint8 interruptState;
+    
+    interruptState = CyEnterCriticalSection();
+    stamp = PROFILE_TIMER_MASK - CySysTickGetValue();
+    
+    if(profileRecording)
+    {
+        profileRing[profileRingHead] = ((uint32)probe << PROFILE_EVENT_PROBE_SHIFT) |
+            ((uint32)type << PROFILE_EVENT_TYPE_SHIFT) | stamp;
+        profileRingHead = (profileRingHead + 1u) & (PROFILE_RING_SIZE - 1u);
+        if(profileRingCount < PROFILE_RING_SIZE)
+        {
+            profileRingCount++;
+        }
+        
+        if(type == PROFILE_EVENT_BEGIN)
+        {
+            profileBeginStamp[probe] = stamp;
+            profileOpenMask |= bit;
+        }
+        /* An end without a begin, e.g. after a reset of the statistics, is only traced */
+        else if((profileOpenMask & bit) != 0u)
+        {
+            profileOpenMask &= (uint16)~bit;
+            cycles = (stamp - profileBeginStamp[probe]) & PROFILE_TIMER_MASK;
+            
+            if((profileCount[probe] == 0u) || (cycles < profileMin[probe]))
+            {
+                profileMin[probe] = cycles;
+            }
+            if(cycles > profileMax[probe])
+            {
+                profileMax[probe] = cycles;
+            }
+            profileSum[probe] += cycles;
+            profileCount[probe]++;
+            
+            /* No CLZ on the Cortex-M0 */
+            for(bin = 0u; (bin < (PROFILE_HIST_BINS - 1u)) && (cycles >= ((uint32)PROFILE_HIST_BASE << bin)); bin++)
+            {
+            }
+            if(profileHistogram[probe][bin] != 0xFFFFu)
+            {
+                profileHistogram[probe][bin]++;
+            }
+        }
+    }
+    
+    CyExitCriticalSection(interruptState);
+}
+
+/*******************************************************************************
+* Function Name: ProfileReset
+********************************************************************************/
+/* Clear the trace ring and the statistics of every probe. */
+void ProfileReset(void)
+{
+    uint8 probe;
+    uint8 bin;
+    uint8 interruptState;
+    
+    interruptState = CyEnterCriticalSection();
+    for(probe = 0u; probe < PROFILE_PROBE_COUNT; probe++)
+    {
+        profileCount[probe] = 0u;
+        profileMin[probe] = 0u;
+        profileMax[probe] = 0u;
+        profileSum[probe] = 0u;
+        for(bin = 0u; bin < PROFILE_HIST_BINS; bin++)
+        {
+            profileHistogram[probe][bin] = 0u;
+        }
+    }
+    profileRingHead = 0u;
+    profileRingCount = 0u;
+    profileOpenMask = 0u;
+    CyExitCriticalSection(interruptState);
+}
+
+/*******************************************************************************
+* Function Name: ProfilePutByte
+********************************************************************************/
+static void ProfilePutByte(uint8 value)
+{
+    profileChecksum += value;
+    UART_UartPutChar(value);
+}
+
+/*******************************************************************************
+* Function Name: ProfilePut16
+********************************************************************************/
+static void ProfilePut16(uint16 value)
+{
+    ProfilePutByte(LO8(value));
+    ProfilePutByte(HI8(value));
+}
+
+/*******************************************************************************
+* Function Name: ProfilePut32
+********************************************************************************/
+static void ProfilePut32(uint32 value)
+{
+    ProfilePut16(LO16(value));
+    ProfilePut16(HI16(value));
+}
+
+/*******************************************************************************
+* Function Name: ProfileDump
+********************************************************************************/
+/* Send the statistics and the trace ring over the UART in the binary layout of  */
+/* PROFILE_DUMP_MAGIC, then start a new measurement. Recording is paused while   */
+/* the dump is sent so that it does not show up in the trace.                     */
+void ProfileDump(void)
+{
+    uint8 probe;
+    uint8 bin;
+    uint16 i;
+    uint16 index;
+    const char8 *magic = PROFILE_DUMP_MAGIC;
+    
+    profileRecording = FALSE;
+    profileChecksum = 0u;
+    
+    for(i = 0u; magic[i] != '\0'; i++)
+    {
+        ProfilePutByte((uint8)magic[i]);
+    }
+    ProfilePut32(CYDEV_BCLK__SYSCLK__HZ);
+    ProfilePutByte(PROFILE_PROBE_COUNT);
+    ProfilePutByte(PROFILE_HIST_BINS);
+    ProfilePut16(PROFILE_HIST_BASE);
+    ProfilePut16(profileRingCount);
+    
+    for(probe = 0u; probe < PROFILE_PROBE_COUNT; probe++)
+    {
+        ProfilePut32(profileCount[probe]);
+        ProfilePut32(profileMin[probe]);
+        ProfilePut32(profileMax[probe]);
+        ProfilePut32((uint32)profileSum[probe]);
+        ProfilePut32((uint32)(profileSum[probe] >> 32));
+        for(bin = 0u; bin < PROFILE_HIST_BINS; bin++)
+        {
+            ProfilePut16(profileHistogram[probe][bin]);
+        }
+    }
+    
+    /* Oldest event first */
+    index = (profileRingHead - profileRingCount) & (PROFILE_RING_SIZE - 1u);
+    for(i = 0u; i < profileRingCount; i++)
+    {
+        ProfilePut32(profileRing[index]);
+        index = (index + 1u) & (PROFILE_RING_SIZE - 1u);
+    }
+    
+    ProfilePut16(profileChecksum);
+    
+    ProfileReset();
+    profileRecording = TRUE;
+}
+
+#endif /* PROFILE_ENABLED */
+
+/* [] END OF FILE */
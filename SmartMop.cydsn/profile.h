@@ -0,0 +1,97 @@
+/*****************************************************************************
+* File Name: profile.h
+*
+* Version: 1.00
+*
+* Description: Hot-path cycle profiler with a trace ring buffer.
+*
+* Related Document: Code example CE202479
+*
+* Hardware Dependency: See code example CE202479
+*
+******************************************************************************
+* Copyright (2015), Cypress Semiconductor Corporation.
+******************************************************************************
+* This software is owned by Cypress Semiconductor Corporation (Cypress) and is
+* protected by and subject to worldwide patent protection (United States and
+* foreign), United States copyright laws and international treaty provisions.
+* Cypress hereby grants to licensee a personal, non-exclusive, non-transferable
+* license to copy, use, modify, create derivative works of, and compile the
+* Cypress Source Code and derivative works for the sole purpose of creating
+* custom software in support of licensee product to be used only in conjunction
+* with a Cypress integrated circuit as specified in the applicable agreement.
+* Any reproduction, modification, translation, compilation, or representation of
+* this software except as specified above is prohibited without the express
+* written permission of Cypress.
+*
+* Disclaimer: CYPRESS MAKES NO WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, WITH
+* REGARD TO THIS MATERIAL, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+* Cypress reserves the right to make changes without further notice to the
+* materials described herein. Cypress does not assume any liability arising out
+* of the application or use of any product or circuit described herein. Cypress
+* does not authorize its products for use as critical components in life-support
+* systems where a malfunction or failure may reasonably be expected to result in
+* significant injury to the user. The inclusion of Cypress' product in a life-
+* support systems application implies that the manufacturer assumes all risk of
+* such use and in doing so indemnifies Cypress against all charges. Use may be
+* limited by and subject to the applicable Cypress software license agreement.
+*****************************************************************************/
+#if !defined(_PROFILE_H)
+#define _PROFILE_H
+    
+#include <project.h>
+#include <main.h>
+
+
+/* Function prototypes */
+void ProfileEvent(uint8 probe, uint8 type);
+void ProfileReset(void);
+void ProfileDump(void);
+
+/* Probes are removed at compile time unless PROFILE_ENABLED is defined in main.h */
+#if defined(PROFILE_ENABLED)
+    #define PROFILE_BEGIN(probe)    ProfileEvent((probe), PROFILE_EVENT_BEGIN)
+    #define PROFILE_END(probe)      ProfileEvent((probe), PROFILE_EVENT_END)
+#else
+    #define PROFILE_BEGIN(probe)
+    #define PROFILE_END(probe)
+#endif /* PROFILE_ENABLED */
+
+/* Project Constants */
+/* Probes. The host decoder host/profdump.c has the names in the same order */
+#define PROFILE_PROBE_BLE_STACK     (0u)        /* CyBle_ProcessEvents */
+#define PROFILE_PROBE_BLE_EVENT     (1u)        /* CustomEventHandler */
+#define PROFILE_PROBE_SCHEDULER     (2u)        /* SchedulerRun and the tasks it runs */
+#define PROFILE_PROBE_SCAN          (3u)        /* SENSOR_SCAN, frame collection and scan start */
+#define PROFILE_PROBE_FILTER        (4u)        /* FilterProcessFrame */
+#define PROFILE_PROBE_LEVEL         (5u)        /* LevelProcessFrame */
+#define PROFILE_PROBE_MOTION        (6u)        /* Motion update, tilt compensation and slosh gate */
+#define PROFILE_PROBE_BMI2_REGS     (7u)        /* bmi2_i2c_read, the BMI270 register reads */
+#define PROFILE_PROBE_TRACKING      (8u)        /* Baseline tracking and full-tank scaling */
+#define PROFILE_PROBE_INTERFACE     (9u)        /* uProbe and UART interfaces */
+#define PROFILE_PROBE_COUNT         (10u)
+
+#define PROFILE_EVENT_BEGIN         (0u)
+#define PROFILE_EVENT_END           (1u)
+
+#define PROFILE_RING_SIZE           (128u)      /* Events kept in the trace ring buffer, power of two */
+#define PROFILE_TIMER_MASK          (0x00FFFFFFu) /* SysTick is a 24 bit down counter at SYSCLK */
+#define PROFILE_HIST_BINS           (16u)       /* Latency histogram bins per probe */
+#define PROFILE_HIST_BASE           (16u)       /* Bin 0 is below 16 cycles, each bin doubles, the last one is open */
+
+/* Trace event, uint32: probe in bits 31..25, PROFILE_EVENT_END in bit 24, cycle stamp in bits 23..0 */
+#define PROFILE_EVENT_PROBE_SHIFT   (25u)
+#define PROFILE_EVENT_TYPE_SHIFT    (24u)
+
+/* Binary dump sent over the UART by the 'P' command, little endian:
+*  "PRF1", uint32 SYSCLK in Hz, uint8 probe count, uint8 histogram bins, uint16 histogram base, uint16 event count,
+*  per probe uint32 count, min, max, sum low, sum high in cycles and uint16 histogram bins,
+*  the events oldest first and a uint16 sum of all bytes before it */
+#define PROFILE_DUMP_MAGIC          ("PRF1")
+#define PROFILE_DUMP_HEADER_LEN     (14u)
+#define PROFILE_DUMP_PROBE_LEN      (20u + (2u * PROFILE_HIST_BINS))
+
+#endif /* _PROFILE_H */
+
+/* [] END OF FILE */
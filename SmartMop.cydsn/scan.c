@@ -0,0 +1,190 @@
+/*****************************************************************************
+* File Name: scan.c
+*
+* Version: 1.00
+*
+* Description: Boundary-tracking partial CapSense scan.
+*
+* Related Document: Code example CE202479
+*
+* Hardware Dependency: See code example CE202479
+*
+******************************************************************************
+* Copyright (2015), Cypress Semiconductor Corporation.
+******************************************************************************
+* This software is owned by Cypress Semiconductor Corporation (Cypress) and is
+* protected by and subject to worldwide patent protection (United States and
+* foreign), United States copyright laws and international treaty provisions.
+* Cypress hereby grants to licensee a personal, non-exclusive, non-transferable
+* license to copy, use, modify, create derivative works of, and compile the
+* Cypress Source Code and derivative works for the sole purpose of creating
+* custom software in support of licensee product to be used only in conjunction
+* with a Cypress integrated circuit as specified in the applicable agreement.
+* Any reproduction, modification, translation, compilation, or representation of
+* this software except as specified above is prohibited without the express
+* written permission of Cypress.
+*
+* Disclaimer: CYPRESS MAKES NO WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, WITH
+* REGARD TO THIS MATERIAL, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+* Cypress reserves the right to make changes without further notice to the
+* materials described herein. Cypress does not assume any liability arising out
+* of the application or use of any product or circuit described herein. Cypress
+* does not authorize its products for use as critical components in life-support
+* systems where a malfunction or failure may reasonably be expected to result in
+* significant injury to the user. The inclusion of Cypress' product in a life-
+* support systems application implies that the manufacturer assumes all risk of
+* such use and in doing so indemnifies Cypress against all charges. Use may be
+* limited by and subject to the applicable Cypress software license agreement.
+*****************************************************************************/
+#include <project.h>
+#include <main.h>
+#include <scan.h>
+#include <calibration.h>
+
+
+/* Global variables */
+/* Global variables used because this is the method uProbe uses to access firmware data */
+uint8 scanPartialEnabled = TRUE;            /* Scan only the sensors around the boundary between full sweeps */
+uint8 scanSensorCount = NUMSENSORS;         /* Sensors scanned in the last frame */
+uint32 scanFullSweepCount = 0u;             /* Frames with every sensor scanned */
+uint32 scanPartialCount = 0u;               /* Frames with only the boundary sensors scanned */
+/* External globals */
+extern uint8 sensorActiveCount;
+extern uint8 motionSloshing;
+extern uint8 calScaleState;
+extern uint8 streamEnabled;
+
+uint16 scanEnabledMask = SCAN_ALL_SENSORS;  /* Sensors of the scan in progress. Only these have new raw counts */
+uint16 scanFrameMask = 0u;                  /* Sensors with new raw counts in the frame being processed */
+uint32 scanOverrunCount = 0u;               /* Frames that were due before the previous scan completed */
+
+/* Static variables */
+static uint8 scanFullCountdown = SCAN_FULL_PERIOD; /* Partial frames left before the next full sweep */
+static uint8 scanBoundary = 0u;             /* First dry sensor when the window was chosen */
+static volatile uint8 scanFullRequested = TRUE;
+static uint8 scanPending = FALSE;           /* A scan was started and its raw counts were not collected yet */
+
+
+/*******************************************************************************
+* Function Name: ScanRequestFullSweep
+********************************************************************************/
+/* Scan every sensor in the next frame. Can be called from an interrupt. */
+void ScanRequestFullSweep(void)
+{
+    scanFullRequested = TRUE;
+}
+
+/*******************************************************************************
+* Function Name: ScanCollect
+********************************************************************************/
+/* Copy the raw counts of the completed scan into raw[], the frame buffer that is   */
+/* filtered and processed while the hardware scans the next frame into the CapSense */
+/* component buffer. Only the sensors of that scan are copied, the other sensors    */
+/* keep their filtered counts. Returns FALSE and counts an overrun when the scan is */
+/* still in progress, the caller waits for it to complete and calls again.          */
+/* scanFrameMask is the mask of the sensors copied, 0 when no scan was started yet. */
+uint8 ScanCollect(uint16 raw[])
+{
+    uint8 i;
+    
+    if(CapSense_CSD_IsBusy())
+    {
+        scanOverrunCount++;
+        return FALSE;
+    }
+    
+    scanFrameMask = scanPending ? scanEnabledMask : 0u;
+    scanPending = FALSE;
+    for(i = 0u; i < NUMSENSORS; i++)
+    {
+        if((scanFrameMask & (1u << i)) != 0u)
+        {
+            raw[i] = CapSense_CSD_ReadSensorRaw(i);
+        }
+    }
+    return TRUE;
+}
+
+/*******************************************************************************
+* Function Name: ScanStart
+********************************************************************************/
+/* Start the CapSense scan of the next frame. Only the few sensors next to the last   */
+/* known boundary carry new information, so in partial scan mode only the window from */
+/* SCAN_WINDOW_BELOW sensors below to SCAN_WINDOW_ABOVE sensors above the first dry   */
+/* sensor is scanned. ScanCollect only copies the sensors in scanEnabledMask, the    */
+/* other sensors keep their last filtered counts, so the level kernel sees them       */
+/* unchanged and the filter does not freeze a single unfiltered sample.               */
+/* The window is chosen from the level of the frame before the one being collected,  */
+/* a boundary that moved in between is caught by the next boundary check.            */
+/* Every sensor is scanned every SCAN_FULL_PERIOD frames, when the boundary moved to  */
+/* another sensor (the window may have lost it, e.g. on a refill), while the liquid   */
+/* sloshes, on a BMI270 motion interrupt, during full-tank scaling and while the raw */
+/* sensor stream runs, so every streamed frame has new counts of all sensors.         */
+/* Each generic widget of the CapSense component has a single sensor, so the widget   */
+/* number is the sensor number.                                                       */
+void ScanStart(void)
+{
+    uint8 i;
+    uint8 boundary;
+    uint8 low;
+    uint8 high;
+    uint16 mask = SCAN_ALL_SENSORS;
+    uint16 changed;
+    
+    /* sensorActiveCount is in half-sensors, the end sensors are half height */
+    boundary = (uint8)((sensorActiveCount + 1u) >> 1);
+    
+    if(boundary != scanBoundary)
+    {
+        scanBoundary = boundary;
+        scanFullRequested = TRUE;
+    }
+    if(motionSloshing || (calScaleState == CAL_SCALE_RUNNING) || !scanPartialEnabled || streamEnabled)
+    {
+        scanFullRequested = TRUE;
+    }
+    
+    if(scanFullRequested || (--scanFullCountdown == 0u))
+    {
+        scanFullRequested = FALSE;
+        scanFullCountdown = SCAN_FULL_PERIOD;
+        scanSensorCount = NUMSENSORS;
+        scanFullSweepCount++;
+    }
+    else
+    {
+        low = (boundary > SCAN_WINDOW_BELOW) ? (boundary - SCAN_WINDOW_BELOW) : 0u;
+        high = boundary + SCAN_WINDOW_ABOVE;
+        if(high > (NUMSENSORS - 1u))
+        {
+            high = NUMSENSORS - 1u;
+        }
+        mask = (uint16)(((1u << (high + 1u)) - 1u) & ~((1u << low) - 1u));
+        scanSensorCount = high - low + 1u;
+        scanPartialCount++;
+    }
+    
+    /* Only touch the widgets whose state changes */
+    changed = mask ^ scanEnabledMask;
+    for(i = 0u; changed != 0u; i++, changed >>= 1)
+    {
+        if((changed & 1u) != 0u)
+        {
+            if((mask & (1u << i)) != 0u)
+            {
+                CapSense_CSD_EnableWidget(i);
+            }
+            else
+            {
+                CapSense_CSD_DisableWidget(i);
+            }
+        }
+    }
+    scanEnabledMask = mask;
+    
+    CapSense_CSD_ScanEnabledWidgets();
+    scanPending = TRUE;
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,358 @@
+/*****************************************************************************
+* File Name: scheduler.c
+*
+* Version: 1.00
+*
+* Description: Tickless deadline scheduler driven by the WDT match register.
+*
+* Related Document: Code example CE202479
+*
+* Hardware Dependency: See code example CE202479
+*
+******************************************************************************
+* Copyright (2015), Cypress Semiconductor Corporation.
+******************************************************************************
+* This software is owned by Cypress Semiconductor Corporation (Cypress) and is
+* protected by and subject to worldwide patent protection (United States and
+* foreign), United States copyright laws and international treaty provisions.
+* Cypress hereby grants to licensee a personal, non-exclusive, non-transferable
+* license to copy, use, modify, create derivative works of, and compile the
+* Cypress Source Code and derivative works for the sole purpose of creating
+* custom software in support of licensee product to be used only in conjunction
+* with a Cypress integrated circuit as specified in the applicable agreement.
+* Any reproduction, modification, translation, compilation, or representation of
+* this software except as specified above is prohibited without the express
+* written permission of Cypress.
+*
+* Disclaimer: CYPRESS MAKES NO WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, WITH
+* REGARD TO THIS MATERIAL, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+* Cypress reserves the right to make changes without further notice to the
+* materials described herein. Cypress does not assume any liability arising out
+* of the application or use of any product or circuit described herein. Cypress
+* does not authorize its products for use as critical components in life-support
+* systems where a malfunction or failure may reasonably be expected to result in
+* significant injury to the user. The inclusion of Cypress' product in a life-
+* support systems application implies that the manufacturer assumes all risk of
+* such use and in doing so indemnifies Cypress against all charges. Use may be
+* limited by and subject to the applicable Cypress software license agreement.
+*****************************************************************************/
+#include <project.h>
+#include <main.h>
+#include <scheduler.h>
+
+
+/* Global variables */
+/* Global variables used because this is the method uProbe uses to access firmware data */
+uint32 schedulerRunCount[SCHEDULER_TASK_COUNT] = {0u}; /* Number of times each task ran */
+uint32 schedulerWakeCount = 0u;             /* Number of WDT interrupts */
+uint32 schedulerTicksPerMs = 0u;            /* ILO ticks per ms. Fixed precision 24.8 */
+uint32 schedulerMsPerTick = 0u;             /* ms per ILO tick. Fixed precision 16.16 */
+/* External globals */
+extern volatile uint32 systemTimeMs;
+#if (!CY_IP_SRSSV2)
+extern volatile uint32 watchdogMatchValue;
+#endif /* !CY_IP_SRSSV2 */
+
+/* Static variables */
+static SCHEDULER_HANDLER schedulerHandler[SCHEDULER_TASK_COUNT];
+static uint32 schedulerDeadline[SCHEDULER_TASK_COUNT]; /* Absolute deadline in ILO ticks */
+static uint32 schedulerPeriodMs[SCHEDULER_TASK_COUNT]; /* SCHEDULER_ONE_SHOT or the period in ms */
+static uint8 schedulerNext[SCHEDULER_TASK_COUNT]; /* Next task in the deadline queue */
+static uint8 schedulerActive[SCHEDULER_TASK_COUNT];
+static uint8 schedulerHead = SCHEDULER_NONE; /* Task with the earliest deadline */
+static volatile uint32 schedulerBaseTicks = 0u; /* Ticks when the WDT counter was last cleared */
+static volatile uint32 schedulerMsFraction = 0u; /* ms not yet added to systemTimeMs. Fixed precision 16.16 */
+#if (CY_IP_SRSSV2)
+static volatile uint32 schedulerMatch = 0u; /* Match value in the WDT register, the end of the period in progress */
+static uint32 schedulerArmedDeadline = 0u;  /* Deadline the WDT match was programmed for */
+static volatile uint8 schedulerArmed = FALSE;
+#endif /* CY_IP_SRSSV2 */
+
+#define SCHEDULER_MS_TO_TICKS(ms)   (((ms) * schedulerTicksPerMs) >> 8u)
+
+
+/*******************************************************************************
+* Function Name: SchedulerInit
+********************************************************************************/
+/* Empty the deadline queue and set the tick rate from a calibrated ILO count.   */
+/* Must be called after the WDT is configured, the first period uses the match   */
+/* value that is already in the WDT register.                                    */
+void SchedulerInit(uint32 iloCounts, uint32 periodMs)
+{
+    uint8 task;
+    
+    for(task = 0u; task < SCHEDULER_TASK_COUNT; task++)
+    {
+        schedulerActive[task] = FALSE;
+        schedulerNext[task] = SCHEDULER_NONE;
+    }
+    schedulerHead = SCHEDULER_NONE;
+    SchedulerSetRate(iloCounts, periodMs);
+    
+    #if (CY_IP_SRSSV2)
+        schedulerMatch = CySysWdtReadMatch(CY_SYS_WDT_COUNTER0);
+        schedulerArmed = FALSE;
+    #endif /* CY_IP_SRSSV2 */
+}
+
+/*******************************************************************************
+* Function Name: SchedulerSetRate
+********************************************************************************/
+/* Set the conversion between ms and ILO ticks. iloCounts is the number of ILO    */
+/* cycles in periodMs as measured by CySysClkIloCompensate. Deadlines already in  */
+/* the queue are kept, new deadlines and periods use the new rate.                */
+void SchedulerSetRate(uint32 iloCounts, uint32 periodMs)
+{
+    if((iloCounts == 0u) || (periodMs == 0u))
+    {
+        return;
+    }
+    schedulerTicksPerMs = (iloCounts << 8u) / periodMs;
+    schedulerMsPerTick = (periodMs << 16u) / iloCounts;
+}
+
+/*******************************************************************************
+* Function Name: SchedulerRegister
+********************************************************************************/
+/* Set the function that is called when the task is due. */
+void SchedulerRegister(uint8 task, SCHEDULER_HANDLER handler)
+{
+    schedulerHandler[task] = handler;
+}
+
+/*******************************************************************************
+* Function Name: SchedulerRemove
+********************************************************************************/
+/* Take the task out of the deadline queue. */
+static void SchedulerRemove(uint8 task)
+{
+    uint8 *link = &schedulerHead;
+    
+    while(*link != SCHEDULER_NONE)
+    {
+        if(*link == task)
+        {
+            *link = schedulerNext[task];
+            break;
+        }
+        link = &schedulerNext[*link];
+    }
+    schedulerActive[task] = FALSE;
+}
+
+/*******************************************************************************
+* Function Name: SchedulerInsert
+********************************************************************************/
+/* Put the task into the deadline queue behind all tasks with an earlier or the  */
+/* same deadline. Deadlines are compared as signed distances, so the queue keeps  */
+/* working when the tick counter wraps.                                           */
+static void SchedulerInsert(uint8 task)
+{
+    uint8 *link = &schedulerHead;
+    uint32 deadline = schedulerDeadline[task];
+    
+    while((*link != SCHEDULER_NONE) && ((int32)(schedulerDeadline[*link] - deadline) <= 0))
+    {
+        link = &schedulerNext[*link];
+    }
+    schedulerNext[task] = *link;
+    *link = task;
+    schedulerActive[task] = TRUE;
+}
+
+/*******************************************************************************
+* Function Name: SchedulerStart
+********************************************************************************/
+/* Run the task delayMs from now and then every periodMs. A task that is already */
+/* queued is moved to the new deadline. SCHEDULER_ONE_SHOT runs the task once.    */
+void SchedulerStart(uint8 task, uint32 delayMs, uint32 periodMs)
+{
+    if(schedulerActive[task])
+    {
+        SchedulerRemove(task);
+    }
+    schedulerPeriodMs[task] = periodMs;
+    schedulerDeadline[task] = SchedulerNowTicks() + SCHEDULER_MS_TO_TICKS(delayMs);
+    SchedulerInsert(task);
+}
+
+/*******************************************************************************
+* Function Name: SchedulerStop
+********************************************************************************/
+/* Remove the task from the queue. The WDT is reprogrammed by the next SchedulerRun. */
+void SchedulerStop(uint8 task)
+{
+    if(schedulerActive[task])
+    {
+        SchedulerRemove(task);
+    }
+}
+
+/*******************************************************************************
+* Function Name: SchedulerIsActive
+********************************************************************************/
+/* Returns TRUE if the task is waiting for its deadline. */
+uint8 SchedulerIsActive(uint8 task)
+{
+    return schedulerActive[task];
+}
+
+#if (CY_IP_SRSSV2)
+/*******************************************************************************
+* Function Name: SchedulerReadCount
+********************************************************************************/
+/* Ticks since the time base. The counter still holds the match value for one    */
+/* tick after the match, when the interrupt has already advanced the time base.  */
+/* That tick is the last tick of the previous period. Call in a critical section.*/
+static uint32 SchedulerReadCount(void)
+{
+    uint32 count = CySysWdtReadCount(CY_SYS_WDT_COUNTER0);
+    
+    if((CySysWdtGetInterruptSource() & CY_SYS_WDT_COUNTER0_INT) != 0u)
+    {
+        /* The interrupt has not run yet, the period is still in progress */
+        return count;
+    }
+    return (count >= schedulerMatch) ? (uint32)-1 : count;
+}
+#endif /* CY_IP_SRSSV2 */
+
+/*******************************************************************************
+* Function Name: SchedulerNowTicks
+********************************************************************************/
+/* Current time in ILO ticks. On devices with a clear-on-match WDT counter this   */
+/* is the time base of the last WDT interrupt plus the counter.                   */
+uint32 SchedulerNowTicks(void)
+{
+    uint32 now;
+    
+    #if (CY_IP_SRSSV2)
+        uint8 interruptState = CyEnterCriticalSection();
+        
+        now = schedulerBaseTicks + SchedulerReadCount();
+        
+        CyExitCriticalSection(interruptState);
+    #else
+        /* The WDT interrupts at a fixed period, deadlines are resolved to that period */
+        now = schedulerBaseTicks;
+    #endif /* CY_IP_SRSSV2 */
+    
+    return now;
+}
+
+/*******************************************************************************
+* Function Name: SchedulerArm
+********************************************************************************/
+/* Program the WDT match for the earliest deadline. The counter is not reset, the */
+/* match is moved relative to the running count so no time is lost. The write is  */
+/* skipped when the match is already set for this deadline, because it blocks for */
+/* 3 ILO cycles. Without tasks the WDT still interrupts at the end of the counter */
+/* range to keep the time base.                                                   */
+static void SchedulerArm(void)
+{
+    #if (CY_IP_SRSSV2)
+        uint8 interruptState;
+        uint32 count;
+        uint32 now;
+        uint32 deadline;
+        uint32 distance;
+        uint32 match;
+        
+        interruptState = CyEnterCriticalSection();
+        
+        /* A pending interrupt has not advanced the time base by the old match yet. Let it */
+        /* run and wait for the counter to clear before the match is changed               */
+        while(((CySysWdtGetInterruptSource() & CY_SYS_WDT_COUNTER0_INT) != 0u) ||
+            (CySysWdtReadCount(CY_SYS_WDT_COUNTER0) >= schedulerMatch))
+        {
+            CyExitCriticalSection(interruptState);
+            interruptState = CyEnterCriticalSection();
+        }
+        
+        count = CySysWdtReadCount(CY_SYS_WDT_COUNTER0);
+        now = schedulerBaseTicks + count;
+        deadline = (schedulerHead != SCHEDULER_NONE) ? schedulerDeadline[schedulerHead] : (now + SCHEDULER_MAX_TICKS);
+        
+        if(!schedulerArmed || ((schedulerHead != SCHEDULER_NONE) && (deadline != schedulerArmedDeadline)))
+        {
+            distance = ((int32)(deadline - now) > (int32)SCHEDULER_MIN_TICKS) ? (deadline - now) : SCHEDULER_MIN_TICKS;
+            
+            /* Deadlines beyond the 16 bit counter take an extra wakeup */
+            match = count + distance;
+            if(match > SCHEDULER_MAX_TICKS)
+            {
+                match = SCHEDULER_MAX_TICKS;
+            }
+            
+            CySysWdtWriteMatch(CY_SYS_WDT_COUNTER0, match);
+            schedulerMatch = match;
+            schedulerArmedDeadline = deadline;
+            schedulerArmed = TRUE;
+        }
+        
+        CyExitCriticalSection(interruptState);
+    #endif /* CY_IP_SRSSV2 */
+}
+
+/*******************************************************************************
+* Function Name: SchedulerRun
+********************************************************************************/
+/* Call the handlers of all due tasks and program the WDT for the next deadline. */
+/* Tasks due within SCHEDULER_MIN_TICKS run now instead of after another wakeup.  */
+/* A periodic task that missed whole periods is not run back to back, its next    */
+/* deadline is one period from now.                                               */
+void SchedulerRun(void)
+{
+    uint8 task;
+    uint32 now = SchedulerNowTicks();
+    
+    while((schedulerHead != SCHEDULER_NONE) &&
+        ((int32)(schedulerDeadline[schedulerHead] - now) <= (int32)SCHEDULER_MIN_TICKS))
+    {
+        task = schedulerHead;
+        schedulerHead = schedulerNext[task];
+        schedulerActive[task] = FALSE;
+        
+        if(schedulerPeriodMs[task] != SCHEDULER_ONE_SHOT)
+        {
+            schedulerDeadline[task] += SCHEDULER_MS_TO_TICKS(schedulerPeriodMs[task]);
+            if((int32)(schedulerDeadline[task] - now) <= 0)
+            {
+                schedulerDeadline[task] = now + SCHEDULER_MS_TO_TICKS(schedulerPeriodMs[task]);
+            }
+            SchedulerInsert(task);
+        }
+        
+        schedulerRunCount[task]++;
+        schedulerHandler[task]();
+    }
+    
+    SchedulerArm();
+}
+
+/*******************************************************************************
+* Function Name: SchedulerTimerInterrupt
+********************************************************************************/
+/* Called from the WDT interrupt. Advances the time base by the WDT period that   */
+/* just ended and systemTimeMs by the same time in ms.                            */
+void SchedulerTimerInterrupt(void)
+{
+    uint32 elapsed;
+    
+    #if (CY_IP_SRSSV2)
+        /* The counter is cleared on the tick after the match */
+        elapsed = schedulerMatch + 1u;
+        schedulerArmed = FALSE;
+    #else
+        elapsed = watchdogMatchValue;
+    #endif /* CY_IP_SRSSV2 */
+    
+    schedulerBaseTicks += elapsed;
+    schedulerMsFraction += elapsed * schedulerMsPerTick;
+    systemTimeMs += schedulerMsFraction >> 16u;
+    schedulerMsFraction &= 0xFFFFu;
+    schedulerWakeCount++;
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,81 @@
+/*****************************************************************************
+* File Name: scheduler.h
+*
+* Version: 1.00
+*
+* Description: Tickless deadline scheduler driven by the WDT match register.
+*
+* Related Document: Code example CE202479
+*
+* Hardware Dependency: See code example CE202479
+*
+******************************************************************************
+* Copyright (2015), Cypress Semiconductor Corporation.
+******************************************************************************
+* This software is owned by Cypress Semiconductor Corporation (Cypress) and is
+* protected by and subject to worldwide patent protection (United States and
+* foreign), United States copyright laws and international treaty provisions.
+* Cypress hereby grants to licensee a personal, non-exclusive, non-transferable
+* license to copy, use, modify, create derivative works of, and compile the
+* Cypress Source Code and derivative works for the sole purpose of creating
+* custom software in support of licensee product to be used only in conjunction
+* with a Cypress integrated circuit as specified in the applicable agreement.
+* Any reproduction, modification, translation, compilation, or representation of
+* this software except as specified above is prohibited without the express
+* written permission of Cypress.
+*
+* Disclaimer: CYPRESS MAKES NO WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, WITH
+* REGARD TO THIS MATERIAL, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+* Cypress reserves the right to make changes without further notice to the
+* materials described herein. Cypress does not assume any liability arising out
+* of the application or use of any product or circuit described herein. Cypress
+* does not authorize its products for use as critical components in life-support
+* systems where a malfunction or failure may reasonably be expected to result in
+* significant injury to the user. The inclusion of Cypress' product in a life-
+* support systems application implies that the manufacturer assumes all risk of
+* such use and in doing so indemnifies Cypress against all charges. Use may be
+* limited by and subject to the applicable Cypress software license agreement.
+*****************************************************************************/
+#if !defined(_SCHEDULER_H)
+#define _SCHEDULER_H
+    
+#include <project.h>
+
+
+/* Task handler, called from SchedulerRun in the main loop */
+typedef void (*SCHEDULER_HANDLER)(void);
+
+/* Function prototypes */
+void SchedulerInit(uint32 iloCounts, uint32 periodMs);
+void SchedulerSetRate(uint32 iloCounts, uint32 periodMs);
+void SchedulerRegister(uint8 task, SCHEDULER_HANDLER handler);
+void SchedulerStart(uint8 task, uint32 delayMs, uint32 periodMs);
+void SchedulerStop(uint8 task);
+uint8 SchedulerIsActive(uint8 task);
+void SchedulerRun(void);
+void SchedulerTimerInterrupt(void);
+uint32 SchedulerNowTicks(void);
+
+/* Project Constants */
+/* Tasks, in order of priority when several are due at the same tick */
+#define SCHEDULER_TASK_SCAN         (0u)            /* Start the next CapSense frame */
+#define SCHEDULER_TASK_CONN         (1u)            /* Connection parameter and CCCD update after connect */
+#define SCHEDULER_TASK_NOTIFY       (2u)            /* Level notification pacing */
+#define SCHEDULER_TASK_LED          (3u)            /* Status LED blinking while advertising */
+#define SCHEDULER_TASK_ILO          (4u)            /* ILO recalibration */
+#define SCHEDULER_TASK_DIAG         (5u)            /* Residency diagnostics characteristic refresh */
+#define SCHEDULER_TASK_HISTORY      (6u)            /* Level history sample while disconnected */
+#define SCHEDULER_TASK_SYNC         (7u)            /* Level history transfer to the Central device */
+#define SCHEDULER_TASK_ESTIMATOR    (8u)            /* Consumption rate and time to empty level sample */
+#define SCHEDULER_TASK_COUNT        (9u)
+
+#define SCHEDULER_ONE_SHOT          (0u)            /* Period of a task that runs once */
+#define SCHEDULER_NONE              (0xFFu)         /* End of the deadline queue */
+#define SCHEDULER_MIN_TICKS         (4u)            /* Shortest WDT match distance. A match write takes 3 ILO cycles to take effect */
+#define SCHEDULER_MAX_TICKS         (0xFFFFu)       /* WDT counter 0 is 16 bit */
+#define SCHEDULER_RATE_SHIFT        (16u)           /* Fixed precision of the tick rate conversion factors */
+
+#endif /* _SCHEDULER_H */
+
+/* [] END OF FILE */
@@ -0,0 +1,298 @@
+/*****************************************************************************
+* File Name: stream.c
+*
+* Version: 1.00
+*
+* Description: Delta-compressed raw sensor streaming over BLE notifications.
+*
+* Related Document: Code example CE202479
+*
+* Hardware Dependency: See code example CE202479
+*
+******************************************************************************
+* Copyright (2015), Cypress Semiconductor Corporation.
+******************************************************************************
+* This software is owned by Cypress Semiconductor Corporation (Cypress) and is
+* protected by and subject to worldwide patent protection (United States and
+* foreign), United States copyright laws and international treaty provisions.
+* Cypress hereby grants to licensee a personal, non-exclusive, non-transferable
+* license to copy, use, modify, create derivative works of, and compile the
+* Cypress Source Code and derivative works for the sole purpose of creating
+* custom software in support of licensee product to be used only in conjunction
+* with a Cypress integrated circuit as specified in the applicable agreement.
+* Any reproduction, modification, translation, compilation, or representation of
+* this software except as specified above is prohibited without the express
+* written permission of Cypress.
+*
+* Disclaimer: CYPRESS MAKES NO WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, WITH
+* REGARD TO THIS MATERIAL, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+* Cypress reserves the right to make changes without further notice to the
+* materials described herein. Cypress does not assume any liability arising out
+* of the application or use of any product or circuit described herein. Cypress
+* does not authorize its products for use as critical components in life-support
+* systems where a malfunction or failure may reasonably be expected to result in
+* significant injury to the user. The inclusion of Cypress' product in a life-
+* support systems application implies that the manufacturer assumes all risk of
+* such use and in doing so indemnifies Cypress against all charges. Use may be
+* limited by and subject to the applicable Cypress software license agreement.
+*****************************************************************************/
+#include <project.h>
+#include <main.h>
+#include <notify.h>
+#include <stream.h>
+#include <string.h>
+
+
+/* Global variables */
+/* Global variables used because this is the method uProbe uses to access firmware data */
+uint8 streamEnabled = FALSE;                /* Set while the Central device has the stream notifications enabled */
+uint8 streamFields = STREAM_FIELD_ALL;      /* STREAM_FIELD_ bits sent, written through the stream characteristic */
+uint32 streamFrameCount = 0u;               /* Frames queued */
+uint32 streamDroppedFrames = 0u;            /* Frames lost because the notification queue was full */
+uint32 streamByteCount = 0u;                /* Bytes of the frames queued, without the notification headers */
+uint32 streamRefusedCount = 0u;             /* Stream starts refused because the MTU was below STREAM_MTU_MIN */
+/* External globals */
+extern uint16 sensorRaw[];
+extern int16 sensorDiff[];
+extern int16 sensorProcessed[];
+extern uint32 frameCount;
+extern uint16 NegotiatedMtu;
+extern volatile uint32 systemTimeMs;
+
+/* Static variables */
+static uint8 streamBuffer[NOTIFY_QUEUE_DATA_LEN];   /* Notification being filled */
+static uint16 streamLength = 0u;                    /* Bytes in streamBuffer */
+static uint8 streamCount = 0u;                      /* Frames in streamBuffer */
+static uint8 streamSequence = 0u;                   /* Sequence of the notification being filled */
+static uint8 streamKeyframe = TRUE;                 /* The next notification is a keyframe */
+static uint8 streamHeaderFields = 0u;               /* STREAM_FIELD_ bits of the notification being filled */
+static int32 streamPrevious[STREAM_FIELD_COUNT][NUMSENSORS]; /* Values of the last frame queued */
+static uint32 streamLastFrame = 0u;                 /* frameCount of the last frame queued */
+static uint32 streamLastMs = 0u;                    /* systemTimeMs of the last frame queued */
+static uint32 streamFirstMs = 0u;                   /* systemTimeMs of the first frame in streamBuffer */
+
+
+/*******************************************************************************
+* Function Name: StreamPutVarint
+********************************************************************************/
+/* Write value 7 bits per byte, least significant first. Returns the bytes written. */
+static uint8 StreamPutVarint(uint8 buffer[], uint32 value)
+{
+    uint8 length = 0u;
+    
+    while(value >= 0x80u)
+    {
+        buffer[length++] = (uint8)(value | 0x80u);
+        value >>= 7;
+    }
+    buffer[length++] = (uint8)value;
+    return length;
+}
+
+/*******************************************************************************
+* Function Name: StreamFieldValue
+********************************************************************************/
+/* Current value of a sensor in field 0 raw, 1 diff or 2 processed. */
+static int32 StreamFieldValue(uint8 field, uint8 sensor)
+{
+    if(field == 0u)
+    {
+        return (int32)sensorRaw[sensor];
+    }
+    if(field == 1u)
+    {
+        return (int32)sensorDiff[sensor];
+    }
+    return (int32)sensorProcessed[sensor];
+}
+
+/*******************************************************************************
+* Function Name: StreamEncodeFrame
+********************************************************************************/
+/* Encode the current frame against the last frame queued, or absolute as the    */
+/* first frame of a keyframe notification. Nothing is committed, so the frame     */
+/* can be encoded again when it does not fit. Returns the bytes written.          */
+static uint16 StreamEncodeFrame(uint8 buffer[])
+{
+    uint8 absolute = streamKeyframe && (streamCount == 0u);
+    uint16 length = 0u;
+    uint8 field;
+    uint8 sensor;
+    int32 delta;
+    
+    length += StreamPutVarint(&buffer[length], frameCount - streamLastFrame);
+    length += StreamPutVarint(&buffer[length], systemTimeMs - streamLastMs);
+    
+    for(field = 0u; field < STREAM_FIELD_COUNT; field++)
+    {
+        if(streamHeaderFields & (1u << field))
+        {
+            for(sensor = 0u; sensor < NUMSENSORS; sensor++)
+            {
+                delta = StreamFieldValue(field, sensor);
+                if(!absolute)
+                {
+                    delta -= streamPrevious[field][sensor];
+                }
+                /* Zigzag, small changes of either sign fit in one byte */
+                length += StreamPutVarint(&buffer[length], ((uint32)delta << 1) ^ (uint32)(delta >> 31));
+            }
+        }
+    }
+    return length;
+}
+
+/*******************************************************************************
+* Function Name: StreamBegin
+********************************************************************************/
+/* Start a notification with the current frame as its first frame. */
+static void StreamBegin(void)
+{
+    streamHeaderFields = streamFields & STREAM_FIELD_ALL;
+    streamLastFrame = frameCount;
+    streamLastMs = systemTimeMs;
+    streamFirstMs = systemTimeMs;
+    
+    streamBuffer[STREAM_NTF_SEQUENCE] = streamSequence;
+    streamBuffer[STREAM_NTF_FLAGS] = streamHeaderFields | (streamKeyframe ? STREAM_FLAG_KEYFRAME : 0u);
+    streamBuffer[STREAM_NTF_FRAME] = LO8(frameCount);
+    streamBuffer[STREAM_NTF_FRAME + 1u] = HI8(frameCount);
+    streamBuffer[STREAM_NTF_FRAME + 2u] = LO8(HI16(frameCount));
+    streamBuffer[STREAM_NTF_FRAME + 3u] = HI8(HI16(frameCount));
+    streamBuffer[STREAM_NTF_TIME] = LO8(systemTimeMs);
+    streamBuffer[STREAM_NTF_TIME + 1u] = HI8(systemTimeMs);
+    streamBuffer[STREAM_NTF_TIME + 2u] = LO8(HI16(systemTimeMs));
+    streamBuffer[STREAM_NTF_TIME + 3u] = HI8(HI16(systemTimeMs));
+    streamLength = STREAM_NTF_FRAMES;
+}
+
+/*******************************************************************************
+* Function Name: StreamFlush
+********************************************************************************/
+/* Queue the notification being filled. It uses the queue only while more than   */
+/* NOTIFY_QUEUE_RESERVED entries are free. When it is dropped, the next           */
+/* notification is a keyframe so the decoder recovers after the gap.              */
+static void StreamFlush(void)
+{
+    if(streamCount == 0u)
+    {
+        return;
+    }
+    
+    streamBuffer[STREAM_NTF_COUNT] = streamCount;
+    if((NotifyQueueSpace() > NOTIFY_QUEUE_RESERVED) &&
+        NotifyQueuePut(STREAM_CHAR_HANDLE, streamBuffer, streamLength, FALSE, NULL, NULL))
+    {
+        streamFrameCount += streamCount;
+        streamByteCount += streamLength - STREAM_NTF_FRAMES;
+        streamKeyframe = (((uint8)(streamSequence + 1u) % STREAM_KEYFRAME_PERIOD) == 0u);
+        ConnectionMarkActivity();
+    }
+    else
+    {
+        streamDroppedFrames += streamCount;
+        streamKeyframe = TRUE;
+    }
+    streamSequence++;
+    streamCount = 0u;
+}
+
+/*******************************************************************************
+* Function Name: StreamStart
+********************************************************************************/
+/* Start streaming with a keyframe, when the Central device enables the stream    */
+/* notifications. Refused, returns FALSE, until the Central device exchanges the  */
+/* MTU to STREAM_MTU_MIN: a keyframe of all fields does not fit the default MTU.  */
+uint8 StreamStart(void)
+{
+    if(NegotiatedMtu < STREAM_MTU_MIN)
+    {
+        streamRefusedCount++;
+        streamEnabled = FALSE;
+        return FALSE;
+    }
+    
+    streamCount = 0u;
+    streamSequence = 0u;
+    streamKeyframe = TRUE;
+    streamEnabled = TRUE;
+    return TRUE;
+}
+
+/*******************************************************************************
+* Function Name: StreamStop
+********************************************************************************/
+/* Stop streaming and discard the notification being filled. */
+void StreamStop(void)
+{
+    streamEnabled = FALSE;
+    streamCount = 0u;
+}
+
+/*******************************************************************************
+* Function Name: StreamRecord
+********************************************************************************/
+/* Add the current frame to the stream, once per processed frame. Frames are      */
+/* batched until the next one does not fit in the negotiated MTU or the first     */
+/* frame is STREAM_LATENCY_MS old. StreamStart made sure that an empty           */
+/* notification holds any frame.                                                  */
+void StreamRecord(void)
+{
+    uint8 frame[STREAM_FRAME_MAX_LEN];
+    uint16 capacity = NegotiatedMtu - NOTIFICATION_HEADER_LEN;
+    uint16 length;
+    uint8 field;
+    uint8 sensor;
+    
+    if(!streamEnabled)
+    {
+        return;
+    }
+    
+    /* A new field selection starts over with a keyframe */
+    if((streamFields & STREAM_FIELD_ALL) != streamHeaderFields)
+    {
+        StreamFlush();
+        streamKeyframe = TRUE;
+    }
+    if(streamCount == 0u)
+    {
+        StreamBegin();
+    }
+    
+    length = StreamEncodeFrame(frame);
+    if((streamLength + length) > capacity)
+    {
+        StreamFlush();
+        StreamBegin();
+        length = StreamEncodeFrame(frame);
+        if((streamLength + length) > capacity)
+        {
+            streamDroppedFrames++;
+            return;
+        }
+    }
+    
+    memcpy(&streamBuffer[streamLength], frame, length);
+    streamLength += length;
+    streamCount++;
+    
+    /* The decoder applies the next deltas to this frame */
+    for(field = 0u; field < STREAM_FIELD_COUNT; field++)
+    {
+        for(sensor = 0u; sensor < NUMSENSORS; sensor++)
+        {
+            streamPrevious[field][sensor] = StreamFieldValue(field, sensor);
+        }
+    }
+    streamLastFrame = frameCount;
+    streamLastMs = systemTimeMs;
+    
+    if((streamCount == 0xFFu) || ((systemTimeMs - streamFirstMs) >= STREAM_LATENCY_MS))
+    {
+        StreamFlush();
+    }
+}
+
+/* [] END OF FILE */
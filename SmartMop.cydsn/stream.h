@@ -0,0 +1,80 @@
+/*****************************************************************************
+* File Name: stream.h
+*
+* Version: 1.00
+*
+* Description: Delta-compressed raw sensor streaming over BLE notifications.
+*
+* Related Document: Code example CE202479
+*
+* Hardware Dependency: See code example CE202479
+*
+******************************************************************************
+* Copyright (2015), Cypress Semiconductor Corporation.
+******************************************************************************
+* This software is owned by Cypress Semiconductor Corporation (Cypress) and is
+* protected by and subject to worldwide patent protection (United States and
+* foreign), United States copyright laws and international treaty provisions.
+* Cypress hereby grants to licensee a personal, non-exclusive, non-transferable
+* license to copy, use, modify, create derivative works of, and compile the
+* Cypress Source Code and derivative works for the sole purpose of creating
+* custom software in support of licensee product to be used only in conjunction
+* with a Cypress integrated circuit as specified in the applicable agreement.
+* Any reproduction, modification, translation, compilation, or representation of
+* this software except as specified above is prohibited without the express
+* written permission of Cypress.
+*
+* Disclaimer: CYPRESS MAKES NO WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, WITH
+* REGARD TO THIS MATERIAL, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+* Cypress reserves the right to make changes without further notice to the
+* materials described herein. Cypress does not assume any liability arising out
+* of the application or use of any product or circuit described herein. Cypress
+* does not authorize its products for use as critical components in life-support
+* systems where a malfunction or failure may reasonably be expected to result in
+* significant injury to the user. The inclusion of Cypress' product in a life-
+* support systems application implies that the manufacturer assumes all risk of
+* such use and in doing so indemnifies Cypress against all charges. Use may be
+* limited by and subject to the applicable Cypress software license agreement.
+*****************************************************************************/
+#if !defined(_STREAM_H)
+#define _STREAM_H
+    
+#include <project.h>
+#include <main.h>
+
+
+/* Function prototypes */
+uint8 StreamStart(void);
+void StreamStop(void);
+void StreamRecord(void);
+
+/* Project Constants */
+#define STREAM_FIELD_RAW            (0x01u)         /* sensorRaw, the counts as scanned */
+#define STREAM_FIELD_DIFF           (0x02u)         /* sensorDiff */
+#define STREAM_FIELD_PROCESSED      (0x04u)         /* sensorProcessed */
+#define STREAM_FIELD_ALL            (STREAM_FIELD_RAW | STREAM_FIELD_DIFF | STREAM_FIELD_PROCESSED)
+#define STREAM_FIELD_COUNT          (3u)
+#define STREAM_FLAG_KEYFRAME        (0x80u)         /* The first frame holds absolute values instead of deltas */
+#define STREAM_KEYFRAME_PERIOD      (32u)           /* Notifications between two keyframes */
+#define STREAM_LATENCY_MS           (1000u)         /* Longest time a frame waits for the notification to fill */
+#define STREAM_VARINT_MAX_LEN       (5u)            /* Bytes of a uint32 varint */
+#define STREAM_FRAME_MAX_LEN        (2u * STREAM_VARINT_MAX_LEN + NUMSENSORS * STREAM_FIELD_COUNT * 3u)
+#define STREAM_MTU_MIN              (NOTIFICATION_HEADER_LEN + STREAM_NTF_FRAMES + STREAM_FRAME_MAX_LEN) /* MTU that holds any frame, above the default MTU */
+
+/* Stream notification, little endian. The frames follow the header, oldest first. Each frame is
+*  a varint of the frameCount increment and a varint of the systemTimeMs increment since the
+*  previous frame, both 0 in the first frame, followed by one zigzag varint per sensor and field
+*  in the header (raw, diff, processed) of the change since the previous frame. In the first
+*  frame of a keyframe notification the values are absolute. Varints are 7 bits per byte, least
+*  significant first, bit 7 set when more bytes follow */
+#define STREAM_NTF_SEQUENCE         (0u)            /* uint8 incremented with every notification, gaps show lost frames */
+#define STREAM_NTF_FLAGS            (1u)            /* uint8 STREAM_FIELD_ bits and STREAM_FLAG_KEYFRAME */
+#define STREAM_NTF_FRAME            (2u)            /* uint32 frameCount of the first frame */
+#define STREAM_NTF_TIME             (6u)            /* uint32 systemTimeMs of the first frame */
+#define STREAM_NTF_COUNT            (10u)           /* uint8 frames in this notification */
+#define STREAM_NTF_FRAMES           (11u)
+
+#endif /* _STREAM_H */
+
+/* [] END OF FILE */
@@ -0,0 +1,285 @@
+/*****************************************************************************
+* File Name: capsense_sim.c
+*
+* Version: 1.00
+*
+* Description: Simulated CapSense_CSD backend for the host build. Generates synthetic liquid profiles or replays recorded raw count traces.
+*
+* Related Document: Code example CE202479
+*
+* Hardware Dependency: See code example CE202479
+*
+******************************************************************************
+* Copyright (2015), Cypress Semiconductor Corporation.
+******************************************************************************
+* This software is owned by Cypress Semiconductor Corporation (Cypress) and is
+* protected by and subject to worldwide patent protection (United States and
+* foreign), United States copyright laws and international treaty provisions.
+* Cypress hereby grants to licensee a personal, non-exclusive, non-transferable
+* license to copy, use, modify, create derivative works of, and compile the
+* Cypress Source Code and derivative works for the sole purpose of creating
+* custom software in support of licensee product to be used only in conjunction
+* with a Cypress integrated circuit as specified in the applicable agreement.
+* Any reproduction, modification, translation, compilation, or representation of
+* this software except as specified above is prohibited without the express
+* written permission of Cypress.
+*
+* Disclaimer: CYPRESS MAKES NO WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, WITH
+* REGARD TO THIS MATERIAL, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+* Cypress reserves the right to make changes without further notice to the
+* materials described herein. Cypress does not assume any liability arising out
+* of the application or use of any product or circuit described herein. Cypress
+* does not authorize its products for use as critical components in life-support
+* systems where a malfunction or failure may reasonably be expected to result in
+* significant injury to the user. The inclusion of Cypress' product in a life-
+* support systems application implies that the manufacturer assumes all risk of
+* such use and in doing so indemnifies Cypress against all charges. Use may be
+* limited by and subject to the applicable Cypress software license agreement.
+*****************************************************************************/
+#include <math.h>
+#include <stdlib.h>
+#include <project.h>
+#include <main.h>
+#include "capsense_sim.h"
+
+
+/* Static variables */
+static SIM_PROFILE simProfile;
+static uint32 simFrames;            /* Frames in a synthetic profile */
+static uint32 simFrame;             /* Current frame */
+static int16 simOffset[NUMSENSORS]; /* Empty counts of each simulated sensor */
+static int16 simScale[NUMSENSORS];  /* Scale the firmware uses for each sensor. Full counts are SENSORMAX / scale */
+static uint16 simRaw[NUMSENSORS];   /* Raw counts of the current frame */
+static uint16 simHeld[NUMSENSORS];  /* Raw counts of each sensor when it was last scanned */
+static uint16 simEnabled = (1u << NUMSENSORS) - 1u; /* Widgets enabled for the scan, one sensor each */
+static double simLevelMm;           /* True level of the current frame */
+static FILE *simTrace;
+static uint32 simRandom = 0x12345678u;
+
+
+/*******************************************************************************
+* Function Name: SimNoise
+********************************************************************************/
+/* Approximately normal noise with unit RMS. Seeded, so runs are repeatable. */
+static double SimNoise(void)
+{
+    double sum = 0.0;
+    uint8 i;
+    
+    for(i = 0; i < 12u; i++)
+    {
+        simRandom = (simRandom * 1664525u) + 1013904223u;
+        sum += (double)(simRandom >> 8) / (double)(1u << 24);
+    }
+    return sum - 6.0;
+}
+
+/*******************************************************************************
+* Function Name: SimSensorFraction
+********************************************************************************/
+/* Submerged fraction of a sensor for a liquid level in mm. The end sensors are half the */
+/* height of the middle sensors, as in LevelProcessFrame.                               */
+static double SimSensorFraction(uint8 sensor, double levelMm)
+{
+    double half = (double)LEVELMM_MAX / (2.0 * (NUMSENSORS - 1u));
+    double bottom = (sensor == 0u) ? 0.0 : half * (2.0 * sensor - 1.0);
+    double height = ((sensor == 0u) || (sensor == NUMSENSORS - 1u)) ? half : 2.0 * half;
+    double frac = (levelMm - bottom) / height;
+    
+    return (frac < 0.0) ? 0.0 : ((frac > 1.0) ? 1.0 : frac);
+}
+
+/*******************************************************************************
+* Function Name: SimStart
+********************************************************************************/
+/* Start a synthetic profile of the given number of frames. offset and scale are the   */
+/* empty counts and scales used by the firmware, so a perfectly calibrated unit is      */
+/* simulated.                                                                           */
+void SimStart(SIM_PROFILE profile, uint32 frames, const int16 offset[], const int16 scale[])
+{
+    simProfile = profile;
+    simFrames = frames;
+    simFrame = 0u;
+    memcpy(simOffset, offset, sizeof(simOffset));
+    memcpy(simScale, scale, sizeof(simScale));
+    simRandom = 0x12345678u;
+}
+
+/*******************************************************************************
+* Function Name: SimStartReplay
+********************************************************************************/
+/* Start replaying a trace. Each line holds NUMSENSORS comma separated raw counts,       */
+/* optionally followed by the true level in mm. Returns 0 on success.                   */
+int SimStartReplay(const char *path)
+{
+    simProfile = SIM_PROFILE_REPLAY;
+    simFrame = 0u;
+    simTrace = fopen(path, "r");
+    return (simTrace == NULL) ? -1 : 0;
+}
+
+/*******************************************************************************
+* Function Name: SimStop
+********************************************************************************/
+void SimStop(void)
+{
+    if(simTrace != NULL)
+    {
+        fclose(simTrace);
+        simTrace = NULL;
+    }
+}
+
+/*******************************************************************************
+* Function Name: SimReplayFrame
+********************************************************************************/
+/* Read the next frame of the trace. Returns FALSE at the end of the trace. */
+static uint8 SimReplayFrame(void)
+{
+    char line[256];
+    char *next;
+    char *field;
+    uint8 i;
+    
+    while(fgets(line, sizeof(line), simTrace) != NULL)
+    {
+        next = line;
+        for(i = 0; i < NUMSENSORS; i++)
+        {
+            field = next;
+            simRaw[i] = (uint16)strtoul(field, &next, 10);
+            if(next == field)
+            {
+                break;
+            }
+            if(*next == ',')
+            {
+                next++;
+            }
+        }
+        /* Skip headers and short lines */
+        if(i < NUMSENSORS)
+        {
+            continue;
+        }
+        field = next;
+        simLevelMm = strtod(field, &next);
+        if(next == field)
+        {
+            simLevelMm = SIM_LEVEL_UNKNOWN;
+        }
+        return TRUE;
+    }
+    return FALSE;
+}
+
+/*******************************************************************************
+* Function Name: SimLatch
+********************************************************************************/
+/* The scan measures the enabled sensors only. Disabled sensors keep their last raw */
+/* counts, as in the CapSense component.                                           */
+static uint8 SimLatch(uint8 frameValid)
+{
+    uint8 i;
+    
+    for(i = 0; frameValid && (i < NUMSENSORS); i++)
+    {
+        if((simEnabled & (1u << i)) != 0u)
+        {
+            simHeld[i] = simRaw[i];
+        }
+    }
+    return frameValid;
+}
+
+/*******************************************************************************
+* Function Name: SimNextFrame
+********************************************************************************/
+/* Produce the raw counts of the next frame. Returns FALSE when the profile is over. */
+uint8 SimNextFrame(void)
+{
+    double t;
+    double level;
+    double noise = SIM_NOISE_COUNTS;
+    double full;
+    double raw;
+    uint8 i;
+    
+    if(simProfile == SIM_PROFILE_REPLAY)
+    {
+        return SimLatch(SimReplayFrame());
+    }
+    if(simFrame >= simFrames)
+    {
+        return FALSE;
+    }
+    
+    t = (double)simFrame / (double)simFrames;
+    switch(simProfile)
+    {
+        case SIM_PROFILE_FILL:
+            level = t * LEVELMM_MAX;
+            break;
+        case SIM_PROFILE_DRAIN:
+            level = (1.0 - t) * LEVELMM_MAX;
+            break;
+        case SIM_PROFILE_SLOSH:
+            level = (LEVELMM_MAX / 2.0) + SIM_SLOSH_AMPLITUDE_MM * sin((2.0 * M_PI * simFrame) / SIM_SLOSH_PERIOD_FRAMES);
+            break;
+        default:
+            level = LEVELMM_MAX * 0.4;
+            noise = SIM_NOISE_EXTRA_COUNTS;
+            break;
+    }
+    /* The volume, and so the true level, does not move while sloshing */
+    simLevelMm = (simProfile == SIM_PROFILE_SLOSH) ? (LEVELMM_MAX / 2.0) : level;
+    
+    for(i = 0; i < NUMSENSORS; i++)
+    {
+        full = ((double)SENSORMAX * 256.0) / simScale[i];
+        raw = simOffset[i] + SimSensorFraction(i, level) * full + noise * SimNoise();
+        simRaw[i] = (raw < 0.0) ? 0u : ((raw > 65535.0) ? 65535u : (uint16)lround(raw));
+    }
+    simFrame++;
+    return SimLatch(TRUE);
+}
+
+/*******************************************************************************
+* Function Name: SimTrueLevelMm
+********************************************************************************/
+/* True level of the current frame in mm, or SIM_LEVEL_UNKNOWN. */
+double SimTrueLevelMm(void)
+{
+    return simLevelMm;
+}
+
+/*******************************************************************************
+* CapSense_CSD API
+********************************************************************************/
+/* Scans complete immediately. The host harness advances frames with SimNextFrame. */
+uint16 CapSense_CSD_ReadSensorRaw(uint32 sensor)
+{
+    return simHeld[sensor];
+}
+
+void CapSense_CSD_ScanEnabledWidgets(void)
+{
+}
+
+uint32 CapSense_CSD_IsBusy(void)
+{
+    return FALSE;
+}
+
+void CapSense_CSD_EnableWidget(uint32 widget)
+{
+    simEnabled |= (uint16)(1u << widget);
+}
+
+void CapSense_CSD_DisableWidget(uint32 widget)
+{
+    simEnabled &= (uint16)~(1u << widget);
+}
+
+/* [] END OF FILE */
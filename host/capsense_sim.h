@@ -0,0 +1,74 @@
+/*****************************************************************************
+* File Name: capsense_sim.h
+*
+* Version: 1.00
+*
+* Description: Simulated CapSense_CSD backend for the host build. Generates synthetic liquid profiles or replays recorded raw count traces.
+*
+* Related Document: Code example CE202479
+*
+* Hardware Dependency: See code example CE202479
+*
+******************************************************************************
+* Copyright (2015), Cypress Semiconductor Corporation.
+******************************************************************************
+* This software is owned by Cypress Semiconductor Corporation (Cypress) and is
+* protected by and subject to worldwide patent protection (United States and
+* foreign), United States copyright laws and international treaty provisions.
+* Cypress hereby grants to licensee a personal, non-exclusive, non-transferable
+* license to copy, use, modify, create derivative works of, and compile the
+* Cypress Source Code and derivative works for the sole purpose of creating
+* custom software in support of licensee product to be used only in conjunction
+* with a Cypress integrated circuit as specified in the applicable agreement.
+* Any reproduction, modification, translation, compilation, or representation of
+* this software except as specified above is prohibited without the express
+* written permission of Cypress.
+*
+* Disclaimer: CYPRESS MAKES NO WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, WITH
+* REGARD TO THIS MATERIAL, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+* Cypress reserves the right to make changes without further notice to the
+* materials described herein. Cypress does not assume any liability arising out
+* of the application or use of any product or circuit described herein. Cypress
+* does not authorize its products for use as critical components in life-support
+* systems where a malfunction or failure may reasonably be expected to result in
+* significant injury to the user. The inclusion of Cypress' product in a life-
+* support systems application implies that the manufacturer assumes all risk of
+* such use and in doing so indemnifies Cypress against all charges. Use may be
+* limited by and subject to the applicable Cypress software license agreement.
+*****************************************************************************/
+#if !defined(_CAPSENSE_SIM_H)
+#define _CAPSENSE_SIM_H
+
+#include <stdio.h>
+#include <project.h>
+#include <main.h>
+
+
+/* Synthetic liquid profiles */
+typedef enum
+{
+    SIM_PROFILE_FILL = 0x00u,   /* Empty to full */
+    SIM_PROFILE_DRAIN = 0x01u,  /* Full to empty */
+    SIM_PROFILE_SLOSH = 0x02u,  /* Half full with the surface rocking across the ladder */
+    SIM_PROFILE_NOISE = 0x03u,  /* Constant level with extra sensor noise */
+    SIM_PROFILE_REPLAY = 0x04u  /* Raw counts read from a trace file */
+} SIM_PROFILE;
+
+/* Function prototypes */
+void SimStart(SIM_PROFILE profile, uint32 frames, const int16 offset[], const int16 scale[]);
+int SimStartReplay(const char *path);
+void SimStop(void);
+uint8 SimNextFrame(void);
+double SimTrueLevelMm(void);
+
+/* Simulation constants */
+#define SIM_NOISE_COUNTS        (4.0)       /* RMS raw count noise of each sensor */
+#define SIM_NOISE_EXTRA_COUNTS  (12.0)      /* RMS raw count noise of the noise profile */
+#define SIM_SLOSH_AMPLITUDE_MM  (10.0)      /* Peak surface movement at the ladder in the slosh profile */
+#define SIM_SLOSH_PERIOD_FRAMES (60.0)      /* Slosh period in frames */
+#define SIM_LEVEL_UNKNOWN       (-1.0)      /* True level of a replayed frame without a level column */
+
+#endif /* _CAPSENSE_SIM_H */
+
+/* [] END OF FILE */
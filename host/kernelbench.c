@@ -0,0 +1,462 @@
+/*****************************************************************************
+* File Name: kernelbench.c
+*
+* Version: 1.00
+*
+* Description: Host benchmark and checks of the per-frame kernels: cycles and ns per frame.
+*
+* Related Document: Code example CE202479
+*
+* Hardware Dependency: See code example CE202479
+*
+******************************************************************************
+* Copyright (2015), Cypress Semiconductor Corporation.
+******************************************************************************
+* This software is owned by Cypress Semiconductor Corporation (Cypress) and is
+* protected by and subject to worldwide patent protection (United States and
+* foreign), United States copyright laws and international treaty provisions.
+* Cypress hereby grants to licensee a personal, non-exclusive, non-transferable
+* license to copy, use, modify, create derivative works of, and compile the
+* Cypress Source Code and derivative works for the sole purpose of creating
+* custom software in support of licensee product to be used only in conjunction
+* with a Cypress integrated circuit as specified in the applicable agreement.
+* Any reproduction, modification, translation, compilation, or representation of
+* this software except as specified above is prohibited without the express
+* written permission of Cypress.
+*
+* Disclaimer: CYPRESS MAKES NO WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, WITH
+* REGARD TO THIS MATERIAL, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+* Cypress reserves the right to make changes without further notice to the
+* materials described herein. Cypress does not assume any liability arising out
+* of the application or use of any product or circuit described herein. Cypress
+* does not authorize its products for use as critical components in life-support
+* systems where a malfunction or failure may reasonably be expected to result in
+* significant injury to the user. The inclusion of Cypress' product in a life-
+* support systems application implies that the manufacturer assumes all risk of
+* such use and in doing so indemnifies Cypress against all charges. Use may be
+* limited by and subject to the applicable Cypress software license agreement.
+*****************************************************************************/
+/*
+* Build and run from the repository root:
+*   gcc -std=gnu99 -O2 -Ihost -ISmartMop.cydsn -o kernelbench host/kernelbench.c \
+*       SmartMop.cydsn/filter.c SmartMop.cydsn/level.c
+*   ./kernelbench
+* Times FilterProcessFrame on KERNELBENCH_FRAMES frames of all sensors for every filter
+* configuration, in host cycles (x86 time stamp counter) and ns per frame. The same configurations
+* are checked on a spike, a step and a partial frame. LevelProcessFrame is timed against the three
+* passes over int32 values that PROCESS_DATA made before the fused kernel, and every output of
+* both is compared on random frames, including counts and scales that saturate. Exits with 1 when
+* a check fails.
+*/
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+#include <project.h>
+#include <main.h>
+#include <filter.h>
+#include <level.h>
+
+
+#define KERNELBENCH_FRAMES      (200000u)
+#define KERNELBENCH_BASE        (1000u)     /* Counts of the test signals */
+#define KERNELBENCH_SPIKE       (500u)      /* Single frame spike the median rejects */
+#define KERNELBENCH_STEP        (400u)      /* Step the filters follow */
+#define KERNELBENCH_SETTLE      (160u)      /* Frames the IIR 1/16 filter takes to follow the step */
+#define KERNELBENCH_ROWS        (1024u)     /* Noisy frames replayed by the timing loop */
+
+/* Level globals, with the empty offsets and scales loaded by LevelInit */
+extern uint16 sensorFiltered[];
+extern int16 sensorDiff[];
+extern int16 sensorEmptyOffset[];
+extern int16 sensorScale[];
+extern int16 sensorProcessed[];
+extern uint16 sensorLimit;
+extern uint8 sensorActiveCount;
+extern int32 sensorHeight;
+extern int32 levelMm;
+extern int32 levelMmStep;
+extern int32 levelPercent;
+
+/* Level kernel outputs */
+typedef struct
+{
+    int32 diff[NUMSENSORS];
+    int32 processed[NUMSENSORS];
+    uint32 activeCount;
+    int32 levelMmStep;
+    int32 levelMm;
+    int32 levelPercent;
+} KERNELBENCH_LEVEL;
+
+/* Filter configuration under test, applied to every sensor */
+typedef struct
+{
+    const char *name;
+    FILTER_CONFIG config;
+} KERNELBENCH_FILTER;
+
+static const KERNELBENCH_FILTER benchFilter[] =
+{
+    { "none",       { FILTER_NONE, 0u, 0u } },
+    { "default",    { FILTER_UNSET, 0u, 0u } },
+    { "median 5",   { FILTER_MEDIAN, FILTER_MEDIAN_SIZE_MAX, 0u } },
+    { "iir 1/16",   { FILTER_IIR, 0u, FILTER_IIR_SHIFT_MAX } },
+    { "jitter",     { FILTER_JITTER, 0u, 0u } },
+    { "all",        { FILTER_MEDIAN | FILTER_IIR | FILTER_JITTER, FILTER_MEDIAN_SIZE_MAX, FILTER_IIR_SHIFT_MAX } }
+};
+
+/* Filter globals */
+extern FILTER_CONFIG filterConfig[];
+extern uint16 filterArenaUsed;
+extern uint8 filterArenaOverflow;
+
+static uint32 benchRandom = 0x12345678u;
+static uint32 benchErrors = 0u;
+
+
+static uint32 BenchRandom(uint32 range)
+{
+    benchRandom = benchRandom * 1103515245u + 12345u;
+    return (benchRandom >> 16) % range;
+}
+
+static double NowNs(void)
+{
+    struct timespec now;
+    
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec * 1e9) + now.tv_nsec;
+}
+
+static uint64_t NowCycles(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return 0u;
+#endif
+}
+
+static void Check(uint8 passed, const char *name, const char *check)
+{
+    if(!passed)
+    {
+        printf("  %s: %s FAIL\n", name, check);
+        benchErrors++;
+    }
+}
+
+static void ApplyFilter(const KERNELBENCH_FILTER *filter)
+{
+    uint8 i;
+    
+    for(i = 0u; i < NUMSENSORS; i++)
+    {
+        filterConfig[i] = filter->config;
+    }
+    FilterInit();
+}
+
+/* Largest difference between the filtered counts and value */
+static uint16 Deviation(const uint16 filtered[], uint16 value)
+{
+    uint16 deviation = 0u;
+    uint16 difference;
+    uint8 i;
+    
+    for(i = 0u; i < NUMSENSORS; i++)
+    {
+        difference = (filtered[i] > value) ? (filtered[i] - value) : (value - filtered[i]);
+        deviation = (difference > deviation) ? difference : deviation;
+    }
+    return deviation;
+}
+
+/* Spike, step and partial frame responses of one configuration */
+static void CheckFilter(const KERNELBENCH_FILTER *filter)
+{
+    uint16 raw[NUMSENSORS];
+    uint16 rawCopy[NUMSENSORS];
+    uint16 filtered[NUMSENSORS];
+    uint16 spikeDeviation = 0u;
+    uint16 deviation;
+    uint32 frame;
+    uint8 i;
+    
+    ApplyFilter(filter);
+    Check(!filterArenaOverflow, filter->name, "fits the arena");
+    if(filter->config.type == FILTER_UNSET)
+    {
+        Check(filterConfig[0].type == FILTER_DEFAULT_TYPE, filter->name, "gets the default filters");
+    }
+    else
+    {
+        Check(filterConfig[0].type == filter->config.type, filter->name, "keeps its filters");
+    }
+    
+    /* A single frame spike on a steady signal */
+    for(frame = 0u; frame < (2u * KERNELBENCH_SETTLE); frame++)
+    {
+        for(i = 0u; i < NUMSENSORS; i++)
+        {
+            raw[i] = KERNELBENCH_BASE + ((frame == KERNELBENCH_SETTLE) ? KERNELBENCH_SPIKE : 0u);
+        }
+        memcpy(rawCopy, raw, sizeof(raw));
+        FilterProcessFrame(raw, filtered, (1u << NUMSENSORS) - 1u);
+        Check(memcmp(raw, rawCopy, sizeof(raw)) == 0, filter->name, "leaves the raw counts");
+        if(frame >= KERNELBENCH_SETTLE)
+        {
+            deviation = Deviation(filtered, KERNELBENCH_BASE);
+            spikeDeviation = (deviation > spikeDeviation) ? deviation : spikeDeviation;
+        }
+    }
+    if(filter->config.type == FILTER_NONE)
+    {
+        Check(spikeDeviation == KERNELBENCH_SPIKE, filter->name, "passes the counts unfiltered");
+    }
+    else if((filter->config.type == FILTER_UNSET) || (filter->config.type & FILTER_MEDIAN))
+    {
+        Check(spikeDeviation == 0u, filter->name, "rejects a single frame spike");
+    }
+    else
+    {
+        Check(spikeDeviation < KERNELBENCH_SPIKE, filter->name, "attenuates a single frame spike");
+    }
+    
+    /* A step is followed to within the jitter filter's count */
+    for(frame = 0u; frame < KERNELBENCH_SETTLE; frame++)
+    {
+        for(i = 0u; i < NUMSENSORS; i++)
+        {
+            raw[i] = KERNELBENCH_BASE + KERNELBENCH_STEP;
+        }
+        FilterProcessFrame(raw, filtered, (1u << NUMSENSORS) - 1u);
+    }
+    Check(Deviation(filtered, KERNELBENCH_BASE + KERNELBENCH_STEP) <= 1u, filter->name, "follows a step");
+    
+    /* Sensors outside the mask keep their filtered counts */
+    memcpy(rawCopy, filtered, sizeof(filtered));
+    for(i = 0u; i < NUMSENSORS; i++)
+    {
+        raw[i] = 0u;
+    }
+    FilterProcessFrame(raw, filtered, 0x0001u);
+    Check(memcmp(&filtered[1], &rawCopy[1], sizeof(filtered) - sizeof(filtered[0])) == 0, filter->name,
+        "leaves the sensors outside the mask");
+}
+
+/* Time one configuration on noisy counts of all sensors */
+static void BenchFilter(const KERNELBENCH_FILTER *filter)
+{
+    static uint16 raw[KERNELBENCH_ROWS][NUMSENSORS];
+    uint16 filtered[NUMSENSORS];
+    uint32 frame;
+    uint8 i;
+    double ns;
+    uint64_t cycles;
+    
+    for(frame = 0u; frame < KERNELBENCH_ROWS; frame++)
+    {
+        for(i = 0u; i < NUMSENSORS; i++)
+        {
+            raw[frame][i] = (uint16)(KERNELBENCH_BASE + 150u * i + BenchRandom(16u));
+        }
+    }
+    
+    ApplyFilter(filter);
+    ns = NowNs();
+    cycles = NowCycles();
+    for(frame = 0u; frame < KERNELBENCH_FRAMES; frame++)
+    {
+        FilterProcessFrame(raw[frame % KERNELBENCH_ROWS], filtered, (1u << NUMSENSORS) - 1u);
+    }
+    cycles = NowCycles() - cycles;
+    ns = NowNs() - ns;
+    
+    printf("%-10s %6u %9.1f %9.1f\n", filter->name, filterArenaUsed,
+        (double)cycles / KERNELBENCH_FRAMES, ns / KERNELBENCH_FRAMES);
+}
+
+static int32 Saturate(int32 count)
+{
+    return (count > LEVEL_PROCESSED_MAX) ? LEVEL_PROCESSED_MAX : ((count < LEVEL_PROCESSED_MIN) ? LEVEL_PROCESSED_MIN : count);
+}
+
+/* PROCESS_DATA before the fused kernel: offset and scale, threshold count and interpolation */
+/* sum in three passes over int32 values */
+static void ReferenceFrame(KERNELBENCH_LEVEL *out)
+{
+    uint32 levelSum = 0u;
+    uint32 frac;
+    uint32 weight;
+    int32 count;
+    uint8 i;
+    
+    for(i = 0u; i < NUMSENSORS; i++)
+    {
+        out->diff[i] = Saturate((int32)sensorFiltered[i] - sensorEmptyOffset[i]);
+        out->processed[i] = Saturate((out->diff[i] * sensorScale[i]) >> 8);
+    }
+    
+    out->activeCount = 0u;
+    for(i = 0u; i < NUMSENSORS; i++)
+    {
+        if(out->processed[i] > (int32)sensorLimit)
+        {
+            out->activeCount += ((i == 0u) || (i == (NUMSENSORS - 1u))) ? LEVEL_WEIGHT_END : LEVEL_WEIGHT_MIDDLE;
+        }
+    }
+    
+    for(i = 0u; i < NUMSENSORS; i++)
+    {
+        count = (out->processed[i] > (int32)SENSORMAX) ? (int32)SENSORMAX : out->processed[i];
+        weight = ((i == 0u) || (i == (NUMSENSORS - 1u))) ? LEVEL_WEIGHT_END : LEVEL_WEIGHT_MIDDLE;
+        frac = (count > 0) ? (((uint32)count * LEVEL_FRAC_RECIP) >> 16) : 0u;
+        if(frac < LEVEL_FRAC_DEADBAND)
+        {
+            frac = 0u;
+        }
+        else if(frac > (LEVEL_FRAC_FULL - LEVEL_FRAC_DEADBAND))
+        {
+            frac = LEVEL_FRAC_FULL;
+        }
+        levelSum += frac * weight;
+    }
+    
+    out->levelMmStep = (int32)(out->activeCount * (uint32)(sensorHeight >> 1));
+    if(out->levelMmStep > ((int32)LEVELMM_MAX << 8) - (sensorHeight >> 2))
+    {
+        out->levelMmStep = LEVELMM_MAX << 8;
+    }
+    out->levelMm = (int32)((levelSum * (uint32)(sensorHeight >> 1)) >> 8);
+    if(out->levelMm > ((int32)LEVELMM_MAX << 8) - (int32)LEVEL_FULL_SNAP)
+    {
+        out->levelMm = LEVELMM_MAX << 8;
+    }
+    out->levelPercent = LEVEL_MM_TO_PERCENT(out->levelMm);
+}
+
+/* Random counts from empty to beyond full, with a few at the ends of the uint16 range */
+static void RandomFrame(void)
+{
+    uint8 i;
+    
+    for(i = 0u; i < NUMSENSORS; i++)
+    {
+        switch(BenchRandom(32u))
+        {
+            case 0u:
+                sensorFiltered[i] = 0u;
+                break;
+            case 1u:
+                sensorFiltered[i] = 0xFFFFu;
+                break;
+            default:
+                sensorFiltered[i] = (uint16)(sensorEmptyOffset[i] + BenchRandom(SENSORMAX + SENSORMAX / 2u));
+                break;
+        }
+    }
+}
+
+/* Compare the fused kernel with the reference on random frames and scales */
+static void CheckLevel(void)
+{
+    static const int16 extremeScale[] = {0x0100, 0x01D0, 0x7FFF, -0x8000, 0x0000};
+    KERNELBENCH_LEVEL reference;
+    uint32 frame;
+    uint32 mismatches = 0u;
+    uint8 i;
+    uint8 same;
+    
+    for(frame = 0u; frame < 100000u; frame++)
+    {
+        RandomFrame();
+        if((frame % 8u) == 0u)
+        {
+            sensorScale[BenchRandom(NUMSENSORS)] = extremeScale[BenchRandom(sizeof(extremeScale) / sizeof(extremeScale[0]))];
+        }
+        ReferenceFrame(&reference);
+        LevelProcessFrame();
+        
+        same = (sensorActiveCount == reference.activeCount) && (levelMmStep == reference.levelMmStep) &&
+            (levelMm == reference.levelMm) && (levelPercent == reference.levelPercent);
+        for(i = 0u; i < NUMSENSORS; i++)
+        {
+            same = same && (sensorDiff[i] == reference.diff[i]) && (sensorProcessed[i] == reference.processed[i]);
+        }
+        if(!same && (mismatches++ < 5u))
+        {
+            printf("  frame %u: level %d/%d mm, step %d/%d mm, active %u/%u, kernel/reference\n", frame,
+                levelMm, reference.levelMm, levelMmStep, reference.levelMmStep, sensorActiveCount, reference.activeCount);
+        }
+    }
+    Check(mismatches == 0u, "LevelProcessFrame", "matches the three passes");
+}
+
+/* Time the fused kernel and the reference on the same frames */
+static void BenchLevel(void)
+{
+    static uint16 raw[KERNELBENCH_ROWS][NUMSENSORS];
+    KERNELBENCH_LEVEL reference;
+    uint32 frame;
+    uint8 pass;
+    double ns;
+    uint64_t cycles;
+    
+    LevelInit();
+    for(frame = 0u; frame < KERNELBENCH_ROWS; frame++)
+    {
+        RandomFrame();
+        memcpy(raw[frame], sensorFiltered, sizeof(raw[0]));
+    }
+    
+    for(pass = 0u; pass < 2u; pass++)
+    {
+        ns = NowNs();
+        cycles = NowCycles();
+        for(frame = 0u; frame < KERNELBENCH_FRAMES; frame++)
+        {
+            memcpy(sensorFiltered, raw[frame % KERNELBENCH_ROWS], sizeof(raw[0]));
+            if(pass == 0u)
+            {
+                LevelProcessFrame();
+            }
+            else
+            {
+                ReferenceFrame(&reference);
+            }
+        }
+        cycles = NowCycles() - cycles;
+        ns = NowNs() - ns;
+        printf("%-10s %9.1f %9.1f\n", (pass == 0u) ? "fused" : "3 passes", (double)cycles / KERNELBENCH_FRAMES, ns / KERNELBENCH_FRAMES);
+    }
+}
+
+int main(void)
+{
+    uint32 index;
+    uint32 count = sizeof(benchFilter) / sizeof(benchFilter[0]);
+    
+    printf("FilterProcessFrame, %u sensors per frame\n", NUMSENSORS);
+    printf("%-10s %6s %9s %9s\n", "filter", "words", "cycles", "ns");
+    for(index = 0u; index < count; index++)
+    {
+        CheckFilter(&benchFilter[index]);
+        BenchFilter(&benchFilter[index]);
+    }
+    
+    printf("\nLevelProcessFrame, %u sensors per frame, frame copy included\n", NUMSENSORS);
+    printf("%-10s %9s %9s\n", "kernel", "cycles", "ns");
+    LevelInit();
+    CheckLevel();
+    BenchLevel();
+    
+    printf("%s\n", (benchErrors == 0u) ? "pass" : "FAIL");
+    return (benchErrors == 0u) ? 0 : 1;
+}
+
+/* [] END OF FILE */
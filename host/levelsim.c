@@ -0,0 +1,270 @@
+/*****************************************************************************
+* File Name: levelsim.c
+*
+* Version: 1.00
+*
+* Description: Host harness that runs the level pipeline over simulated or recorded CapSense frames and reports throughput and accuracy.
+*
+* Related Document: Code example CE202479
+*
+* Hardware Dependency: See code example CE202479
+*
+******************************************************************************
+* Copyright (2015), Cypress Semiconductor Corporation.
+******************************************************************************
+* This software is owned by Cypress Semiconductor Corporation (Cypress) and is
+* protected by and subject to worldwide patent protection (United States and
+* foreign), United States copyright laws and international treaty provisions.
+* Cypress hereby grants to licensee a personal, non-exclusive, non-transferable
+* license to copy, use, modify, create derivative works of, and compile the
+* Cypress Source Code and derivative works for the sole purpose of creating
+* custom software in support of licensee product to be used only in conjunction
+* with a Cypress integrated circuit as specified in the applicable agreement.
+* Any reproduction, modification, translation, compilation, or representation of
+* this software except as specified above is prohibited without the express
+* written permission of Cypress.
+*
+* Disclaimer: CYPRESS MAKES NO WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, WITH
+* REGARD TO THIS MATERIAL, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+* Cypress reserves the right to make changes without further notice to the
+* materials described herein. Cypress does not assume any liability arising out
+* of the application or use of any product or circuit described herein. Cypress
+* does not authorize its products for use as critical components in life-support
+* systems where a malfunction or failure may reasonably be expected to result in
+* significant injury to the user. The inclusion of Cypress' product in a life-
+* support systems application implies that the manufacturer assumes all risk of
+* such use and in doing so indemnifies Cypress against all charges. Use may be
+* limited by and subject to the applicable Cypress software license agreement.
+*****************************************************************************/
+/*
+* Build and run from the repository root:
+*   gcc -std=gnu99 -O2 -Ihost -ISmartMop.cydsn -o levelsim host/levelsim.c host/capsense_sim.c \
+*       SmartMop.cydsn/pipeline.c SmartMop.cydsn/filter.c SmartMop.cydsn/level.c SmartMop.cydsn/scan.c -lm
+*   ./levelsim                   run every synthetic profile
+*   ./levelsim -full ...         scan every sensor in every frame instead of the boundary window
+*   ./levelsim slosh 20000       run one profile for a number of frames
+*   ./levelsim replay trace.csv  replay recorded raw counts, NUMSENSORS per line plus an optional true level in mm
+* The frames run through the PROCESS_DATA front end of the firmware, PipelineProcessFrame, with the
+* empty offsets and scales of its EEPROM arrays. Exits with 1 when the levelMm error of a synthetic
+* profile exceeds its limits in profileLimit.
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <time.h>
+#include <project.h>
+#include <main.h>
+#include <level.h>
+#include <filter.h>
+#include <scan.h>
+#include <pipeline.h>
+#include <calibration.h>
+#include "capsense_sim.h"
+
+
+/* Globals of the motion, calibration and stream modules, which the host does not build */
+uint8 motionSloshing = FALSE;
+uint8 calScaleState = CAL_SCALE_IDLE;
+uint8 streamEnabled = FALSE;
+extern uint16 sensorRaw[];
+extern int16 sensorEmptyOffset[];
+extern int16 sensorScale[];
+extern int32 levelMm;
+extern int32 levelMmStep;
+extern uint8 scanPartialEnabled;
+extern uint8 scanSensorCount;
+extern uint16 scanFrameMask;
+
+/* Results of one run */
+typedef struct
+{
+    uint32 frames;
+    uint32 skipped;
+    uint32 sensorsScanned;  /* Sum of the sensors scanned in each frame */
+    uint32 scored;          /* Frames with a known true level */
+    double processNs;       /* Total time in PipelineProcessFrame */
+    double errorSum;        /* Sum of absolute levelMm errors in mm */
+    double errorMax;
+    double stepErrorSum;    /* Sum of absolute levelMmStep errors in mm */
+    double stepErrorMax;
+} SIM_RESULT;
+
+/* Pass limits of a synthetic profile, levelMm error in mm */
+typedef struct
+{
+    double meanError;
+    double maxError;
+} SIM_LIMIT;
+
+static const char *profileName[] = {"fill", "drain", "slosh", "noise", "replay"};
+
+/* The motion module is not simulated, so sloshing is scored without the level hold */
+static const SIM_LIMIT profileLimit[] =
+{
+    { 0.25, 1.5 },      /* fill */
+    { 0.25, 1.5 },      /* drain */
+    { 7.0, 11.0 },      /* slosh */
+    { 0.25, 1.0 }       /* noise */
+};
+
+
+/*******************************************************************************
+* Function Name: NowNs
+********************************************************************************/
+static double NowNs(void)
+{
+    struct timespec now;
+    
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec * 1e9) + now.tv_nsec;
+}
+
+/*******************************************************************************
+* Function Name: RunPipeline
+********************************************************************************/
+/* Run the SENSOR_SCAN and PROCESS_DATA steps of main() on every simulated frame. */
+static void RunPipeline(SIM_RESULT *result)
+{
+    double start;
+    double trueLevel;
+    double error;
+    
+    memset(result, 0, sizeof(*result));
+    FilterInit();
+    
+    /* Every profile starts with a full sweep, as after power-up */
+    ScanRequestFullSweep();
+    ScanStart();
+    
+    while(SimNextFrame())
+    {
+        /* SENSOR_SCAN, the next frame is scanned while this one is processed */
+        ScanCollect(sensorRaw);
+        ScanStart();
+        
+        /* PROCESS_DATA */
+        start = NowNs();
+        if(!PipelineProcessFrame())
+        {
+            result->skipped++;
+        }
+        result->processNs += NowNs() - start;
+        result->sensorsScanned += scanSensorCount;
+        result->frames++;
+        
+        trueLevel = SimTrueLevelMm();
+        if(trueLevel >= 0.0)
+        {
+            error = fabs((levelMm / 256.0) - trueLevel);
+            result->errorSum += error;
+            result->errorMax = (error > result->errorMax) ? error : result->errorMax;
+            error = fabs((levelMmStep / 256.0) - trueLevel);
+            result->stepErrorSum += error;
+            result->stepErrorMax = (error > result->stepErrorMax) ? error : result->stepErrorMax;
+            result->scored++;
+        }
+    }
+}
+
+/*******************************************************************************
+* Function Name: PrintResult
+********************************************************************************/
+/* Print one run and check it against limit, NULL for a run without limits. Returns FALSE */
+/* when a limit is exceeded.                                                                */
+static uint8 PrintResult(const char *name, const SIM_RESULT *result, const SIM_LIMIT *limit)
+{
+    double frames = (result->frames > 0u) ? result->frames : 1.0;
+    double scored = (result->scored > 0u) ? result->scored : 1.0;
+    uint8 passed = TRUE;
+    
+    printf("%-8s %8u %7.1f%% %7.2f %9.1f %11.0f", name, result->frames, (100.0 * result->skipped) / frames,
+        result->sensorsScanned / frames, result->processNs / frames, (1e9 * frames) / (result->processNs + 1.0));
+    if(result->scored > 0u)
+    {
+        printf(" %8.3f %8.3f %8.3f %8.3f", result->errorSum / scored, result->errorMax,
+            result->stepErrorSum / scored, result->stepErrorMax);
+    }
+    else
+    {
+        printf(" %8s %8s %8s %8s", "-", "-", "-", "-");
+    }
+    
+    if(limit != NULL)
+    {
+        passed = (result->scored > 0u) && ((result->errorSum / scored) <= limit->meanError) &&
+            (result->errorMax <= limit->maxError);
+        printf(" %s", passed ? "pass" : "FAIL");
+    }
+    printf("\n");
+    return passed;
+}
+
+int main(int argc, char *argv[])
+{
+    SIM_RESULT result;
+    uint32 frames = 10000u;
+    int first = SIM_PROFILE_FILL;
+    int last = SIM_PROFILE_NOISE;
+    int profile;
+    uint8 passed = TRUE;
+    
+    if((argc > 1) && (strcmp(argv[1], "-full") == 0))
+    {
+        scanPartialEnabled = FALSE;
+        argc--;
+        argv++;
+    }
+    if((argc > 2) && (strcmp(argv[1], "replay") == 0))
+    {
+        if(SimStartReplay(argv[2]) != 0)
+        {
+            fprintf(stderr, "levelsim: cannot open %s\n", argv[2]);
+            return 1;
+        }
+        first = SIM_PROFILE_REPLAY;
+        last = SIM_PROFILE_REPLAY;
+    }
+    else if(argc > 1)
+    {
+        for(first = SIM_PROFILE_FILL; first <= SIM_PROFILE_NOISE; first++)
+        {
+            if(strcmp(argv[1], profileName[first]) == 0)
+            {
+                break;
+            }
+        }
+        if(first > SIM_PROFILE_NOISE)
+        {
+            fprintf(stderr, "usage: levelsim [-full] [fill|drain|slosh|noise [frames]] | [replay trace.csv]\n");
+            return 1;
+        }
+        last = first;
+        if(argc > 2)
+        {
+            frames = (uint32)strtoul(argv[2], NULL, 10);
+        }
+    }
+    
+    /* Empty offsets and scales of a calibrated unit, as after power-up */
+    LevelInit();
+    
+    printf("%-8s %8s %8s %7s %9s %11s %8s %8s %8s %8s\n", "profile", "frames", "skipped", "sensors", "ns/frame",
+        "frames/s", "mae mm", "max mm", "step mae", "step max");
+    for(profile = first; profile <= last; profile++)
+    {
+        if(profile != SIM_PROFILE_REPLAY)
+        {
+            SimStart((SIM_PROFILE)profile, frames, sensorEmptyOffset, sensorScale);
+        }
+        RunPipeline(&result);
+        SimStop();
+        if(!PrintResult(profileName[profile], &result, (profile != SIM_PROFILE_REPLAY) ? &profileLimit[profile] : NULL))
+        {
+            passed = FALSE;
+        }
+    }
+    return passed ? 0 : 1;
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,165 @@
+/*****************************************************************************
+* File Name: leveltest.c
+*
+* Version: 1.00
+*
+* Description: Host test vectors of the interpolated level against the step level.
+*
+* Related Document: Code example CE202479
+*
+* Hardware Dependency: See code example CE202479
+*
+******************************************************************************
+* Copyright (2015), Cypress Semiconductor Corporation.
+******************************************************************************
+* This software is owned by Cypress Semiconductor Corporation (Cypress) and is
+* protected by and subject to worldwide patent protection (United States and
+* foreign), United States copyright laws and international treaty provisions.
+* Cypress hereby grants to licensee a personal, non-exclusive, non-transferable
+* license to copy, use, modify, create derivative works of, and compile the
+* Cypress Source Code and derivative works for the sole purpose of creating
+* custom software in support of licensee product to be used only in conjunction
+* with a Cypress integrated circuit as specified in the applicable agreement.
+* Any reproduction, modification, translation, compilation, or representation of
+* this software except as specified above is prohibited without the express
+* written permission of Cypress.
+*
+* Disclaimer: CYPRESS MAKES NO WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, WITH
+* REGARD TO THIS MATERIAL, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+* Cypress reserves the right to make changes without further notice to the
+* materials described herein. Cypress does not assume any liability arising out
+* of the application or use of any product or circuit described herein. Cypress
+* does not authorize its products for use as critical components in life-support
+* systems where a malfunction or failure may reasonably be expected to result in
+* significant injury to the user. The inclusion of Cypress' product in a life-
+* support systems application implies that the manufacturer assumes all risk of
+* such use and in doing so indemnifies Cypress against all charges. Use may be
+* limited by and subject to the applicable Cypress software license agreement.
+*****************************************************************************/
+/*
+* Build and run from the repository root:
+*   gcc -std=gnu99 -O2 -Ihost -ISmartMop.cydsn -o leveltest host/leveltest.c SmartMop.cydsn/level.c -lm
+*   ./leveltest
+* Sweeps the true level from empty to full in LEVELTEST_SWEEP_MM steps over noiseless sensor counts
+* of a calibrated unit, runs LevelProcessFrame on each and compares levelMm and levelMmStep with
+* the true level. Prints the vectors at every LEVELTEST_PRINT_MM. Exits with 1 when the
+* interpolated level is off by more than LEVELTEST_MAX_ERROR_MM, is not at least
+* LEVELTEST_GAIN times closer than the step level on average, goes down while the liquid rises or
+* misses empty or full.
+*/
+#include <stdio.h>
+#include <math.h>
+#include <project.h>
+#include <main.h>
+#include <level.h>
+
+
+#define LEVELTEST_SWEEP_MM      (0.05)      /* True level step of the sweep */
+#define LEVELTEST_PRINT_MM      (4.25)      /* Spacing of the printed vectors */
+#define LEVELTEST_MAX_ERROR_MM  (1.0)       /* Largest interpolated level error. The snap deadband is 0.87 mm of a middle sensor */
+#define LEVELTEST_GAIN          (4.0)       /* Mean step level error over mean interpolated level error */
+
+/* Level globals, with the empty offsets and scales loaded by LevelInit */
+extern uint16 sensorFiltered[];
+extern int16 sensorDiff[];
+extern int16 sensorEmptyOffset[];
+extern int16 sensorScale[];
+extern int16 sensorProcessed[];
+extern uint16 sensorLimit;
+extern uint8 sensorActiveCount;
+extern int32 sensorHeight;
+extern int32 levelMm;
+extern int32 levelMmStep;
+extern int32 levelPercent;
+
+static uint32 testErrors = 0u;
+
+
+/* Noiseless counts of every sensor for a true level in mm. The end sensors are half the height */
+/* of the middle sensors, as in capsense_sim.c                                                   */
+static void SetLevel(double trueMm)
+{
+    double half = (double)LEVELMM_MAX / (2.0 * (NUMSENSORS - 1u));
+    double bottom;
+    double height;
+    double frac;
+    uint8 i;
+    
+    for(i = 0u; i < NUMSENSORS; i++)
+    {
+        bottom = (i == 0u) ? 0.0 : half * (2.0 * i - 1.0);
+        height = ((i == 0u) || (i == (NUMSENSORS - 1u))) ? half : 2.0 * half;
+        frac = (trueMm - bottom) / height;
+        frac = (frac < 0.0) ? 0.0 : ((frac > 1.0) ? 1.0 : frac);
+        sensorFiltered[i] = (uint16)(sensorEmptyOffset[i] + lround((frac * SENSORMAX * 256.0) / sensorScale[i]));
+    }
+}
+
+static void Check(uint8 passed, const char *check)
+{
+    printf("%-52s %s\n", check, passed ? "pass" : "FAIL");
+    if(!passed)
+    {
+        testErrors++;
+    }
+}
+
+int main(void)
+{
+    double trueMm;
+    double interpolated;
+    double step;
+    double error;
+    double errorMax = 0.0;
+    double errorSum = 0.0;
+    double stepErrorMax = 0.0;
+    double stepErrorSum = 0.0;
+    double nextPrint = 0.0;
+    int32 previous = 0;
+    uint32 decreases = 0u;
+    uint32 count = 0u;
+    uint32 index;
+    
+    LevelInit();
+    printf("%8s %8s %8s %8s %8s\n", "true mm", "interp", "error", "step", "error");
+    for(index = 0u; (trueMm = index * LEVELTEST_SWEEP_MM) <= (double)LEVELMM_MAX; index++)
+    {
+        SetLevel(trueMm);
+        LevelProcessFrame();
+        
+        interpolated = levelMm / 256.0;
+        step = levelMmStep / 256.0;
+        error = fabs(interpolated - trueMm);
+        errorSum += error;
+        errorMax = (error > errorMax) ? error : errorMax;
+        stepErrorSum += fabs(step - trueMm);
+        stepErrorMax = (fabs(step - trueMm) > stepErrorMax) ? fabs(step - trueMm) : stepErrorMax;
+        decreases += (levelMm < previous);
+        previous = levelMm;
+        count++;
+        
+        if(trueMm >= nextPrint)
+        {
+            printf("%8.2f %8.2f %+8.2f %8.2f %+8.2f\n", trueMm, interpolated, interpolated - trueMm, step, step - trueMm);
+            nextPrint += LEVELTEST_PRINT_MM;
+        }
+    }
+    printf("mean error %.3f mm interpolated, %.3f mm step. Max error %.3f mm interpolated, %.3f mm step\n\n",
+        errorSum / count, stepErrorSum / count, errorMax, stepErrorMax);
+    
+    Check(errorMax <= LEVELTEST_MAX_ERROR_MM, "interpolated error within LEVELTEST_MAX_ERROR_MM");
+    Check((errorSum * LEVELTEST_GAIN) <= stepErrorSum, "interpolated error LEVELTEST_GAIN times below step");
+    Check(decreases == 0u, "interpolated level rises with the liquid");
+    
+    SetLevel(0.0);
+    LevelProcessFrame();
+    Check((levelMm == 0) && (levelPercent == 0), "empty reads 0 mm and 0 percent");
+    SetLevel((double)LEVELMM_MAX);
+    LevelProcessFrame();
+    Check((levelMm == ((int32)LEVELMM_MAX << 8)) && (levelPercent == (100 << 8)), "full reads LEVELMM_MAX and 100 percent");
+    
+    return (testErrors == 0u) ? 0 : 1;
+}
+
+/* [] END OF FILE */
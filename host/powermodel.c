@@ -0,0 +1,288 @@
+/*****************************************************************************
+* File Name: powermodel.c
+*
+* Version: 1.00
+*
+* Description: Host model that turns the state residency diagnostics record into an average current and battery life estimate.
+*
+* Related Document: Code example CE202479
+*
+* Hardware Dependency: See code example CE202479
+*
+******************************************************************************
+* Copyright (2015), Cypress Semiconductor Corporation.
+******************************************************************************
+* This software is owned by Cypress Semiconductor Corporation (Cypress) and is
+* protected by and subject to worldwide patent protection (United States and
+* foreign), United States copyright laws and international treaty provisions.
+* Cypress hereby grants to licensee a personal, non-exclusive, non-transferable
+* license to copy, use, modify, create derivative works of, and compile the
+* Cypress Source Code and derivative works for the sole purpose of creating
+* custom software in support of licensee product to be used only in conjunction
+* with a Cypress integrated circuit as specified in the applicable agreement.
+* Any reproduction, modification, translation, compilation, or representation of
+* this software except as specified above is prohibited without the express
+* written permission of Cypress.
+*
+* Disclaimer: CYPRESS MAKES NO WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, WITH
+* REGARD TO THIS MATERIAL, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+* Cypress reserves the right to make changes without further notice to the
+* materials described herein. Cypress does not assume any liability arising out
+* of the application or use of any product or circuit described herein. Cypress
+* does not authorize its products for use as critical components in life-support
+* systems where a malfunction or failure may reasonably be expected to result in
+* significant injury to the user. The inclusion of Cypress' product in a life-
+* support systems application implies that the manufacturer assumes all risk of
+* such use and in doing so indemnifies Cypress against all charges. Use may be
+* limited by and subject to the applicable Cypress software license agreement.
+*****************************************************************************/
+/*
+* Build and run from the repository root:
+*   gcc -std=gnu99 -O2 -Ihost -ISmartMop.cydsn -o powermodel host/powermodel.c
+*   ./powermodel RECORD                 residency since power-up
+*   ./powermodel RECORD1 RECORD2        residency between two records, e.g. one build's test run
+*   ./powermodel -b 600 -c SLEEP=0.004 RECORD
+* RECORD is the hex string printed after "DIAG " by the UART 'D' command, or the value
+* of the BLE diagnostics characteristic in hex.
+* -b sets the battery capacity in mAh. -c overrides the current in mA of a state
+* (SENSOR_SCAN, WAIT_FOR_SCAN_COMPLETE, PROCESS_DATA, BLE_PROCESS) or sleep depth
+* (ACTIVE, SLEEP, DEEPSLEEP). -f sets the current that flows all the time, e.g. the BMI270.
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <project.h>
+#include <power.h>
+
+
+/* Typical currents in mA at 3 V. Measure once per hardware revision and pass them with -c */
+typedef struct
+{
+    const char *name;
+    double current;
+} MODEL_CURRENT;
+
+static MODEL_CURRENT stateCurrent[POWER_DIAG_STATES] =
+{
+    {"SENSOR_SCAN",             3.20},  /* CPU active at 24 MHz, CSD block starting the scan */
+    {"WAIT_FOR_SCAN_COMPLETE",  1.80},  /* CPU Sleep, CSD block and IDACs scanning */
+    {"PROCESS_DATA",            3.00},  /* CPU active at 24 MHz, I2C reads from the BMI270 */
+    {"BLE_PROCESS",             3.00},  /* CPU active at 24 MHz */
+    {"SLEEP",                   3.00},  /* Loop overhead in SLEEP outside PowerManagerSleep */
+};
+
+static MODEL_CURRENT depthCurrent[POWER_DEPTH_COUNT] =
+{
+    {"ACTIVE",                  3.00},  /* CPU kept active while BLESS closes a connection event */
+    {"SLEEP",                   1.10},  /* CPU Sleep, HFCLK running */
+    {"DEEPSLEEP",               0.0013},/* DeepSleep with WDT and BLESS ECO off, averaged BLE events excluded */
+};
+
+static double floorCurrent = 0.025;     /* BMI270 in low power mode with significant motion enabled */
+static double batteryMah = 300.0;
+
+
+/*******************************************************************************
+* Function Name: ParseRecord
+********************************************************************************/
+/* Convert a hex record into POWER_DIAG_LEN bytes. Returns 0 on success. */
+static int ParseRecord(const char *hex, uint8 record[])
+{
+    uint32 i;
+    unsigned int value;
+    
+    if(strncmp(hex, "DIAG", 4) == 0)
+    {
+        hex += 4;
+    }
+    while(*hex == ' ')
+    {
+        hex++;
+    }
+    if(strlen(hex) < (2u * POWER_DIAG_LEN))
+    {
+        return -1;
+    }
+    for(i = 0u; i < POWER_DIAG_LEN; i++)
+    {
+        if(sscanf(&hex[2u * i], "%2x", &value) != 1)
+        {
+            return -1;
+        }
+        record[i] = (uint8)value;
+    }
+    return 0;
+}
+
+static uint32 Read32(const uint8 record[], uint32 offset)
+{
+    return (uint32)record[offset] | ((uint32)record[offset + 1u] << 8) |
+        ((uint32)record[offset + 2u] << 16) | ((uint32)record[offset + 3u] << 24);
+}
+
+static uint16 Read16(const uint8 record[], uint32 offset)
+{
+    return (uint16)(record[offset] | (record[offset + 1u] << 8));
+}
+
+/*******************************************************************************
+* Function Name: SetCurrent
+********************************************************************************/
+/* Handle a NAME=mA override. Returns 0 on success. */
+static int SetCurrent(const char *option)
+{
+    const char *value = strchr(option, '=');
+    size_t length;
+    uint32 i;
+    
+    if(value == NULL)
+    {
+        return -1;
+    }
+    length = (size_t)(value - option);
+    for(i = 0u; i < POWER_DIAG_STATES; i++)
+    {
+        if((strlen(stateCurrent[i].name) == length) && (strncmp(stateCurrent[i].name, option, length) == 0))
+        {
+            stateCurrent[i].current = atof(value + 1);
+            return 0;
+        }
+    }
+    for(i = 0u; i < POWER_DEPTH_COUNT; i++)
+    {
+        if((strlen(depthCurrent[i].name) == length) && (strncmp(depthCurrent[i].name, option, length) == 0))
+        {
+            depthCurrent[i].current = atof(value + 1);
+            return 0;
+        }
+    }
+    return -1;
+}
+
+int main(int argc, char *argv[])
+{
+    uint8 first[POWER_DIAG_LEN] = {0u};
+    uint8 last[POWER_DIAG_LEN];
+    const char *records[2];
+    int recordCount = 0;
+    int arg;
+    uint32 i;
+    double ticksPerMs;
+    double stateTicks[POWER_DIAG_STATES];
+    double depthTicks[POWER_DEPTH_COUNT];
+    double totalTicks = 0.0;
+    double sleepTicks = 0.0;
+    double stateCharge[POWER_DIAG_STATES]; /* mA * ticks */
+    double depthCharge[POWER_DEPTH_COUNT];
+    double charge = 0.0;
+    double averageCurrent;
+    double hours;
+    uint16 entries;
+    
+    for(arg = 1; arg < argc; arg++)
+    {
+        if((strcmp(argv[arg], "-b") == 0) && (arg + 1 < argc))
+        {
+            batteryMah = atof(argv[++arg]);
+        }
+        else if((strcmp(argv[arg], "-f") == 0) && (arg + 1 < argc))
+        {
+            floorCurrent = atof(argv[++arg]);
+        }
+        else if((strcmp(argv[arg], "-c") == 0) && (arg + 1 < argc))
+        {
+            if(SetCurrent(argv[++arg]) != 0)
+            {
+                fprintf(stderr, "powermodel: unknown state in %s\n", argv[arg]);
+                return 1;
+            }
+        }
+        else if(recordCount < 2)
+        {
+            records[recordCount++] = argv[arg];
+        }
+    }
+    if(recordCount == 0)
+    {
+        fprintf(stderr, "usage: powermodel [-b mAh] [-f mA] [-c STATE=mA] RECORD [RECORD]\n");
+        return 1;
+    }
+    if(((recordCount == 2) && (ParseRecord(records[0], first) != 0)) ||
+        (ParseRecord(records[recordCount - 1], last) != 0))
+    {
+        fprintf(stderr, "powermodel: a record needs %u hex bytes\n", (unsigned int)POWER_DIAG_LEN);
+        return 1;
+    }
+    
+    /* The counters wrap, unsigned differences stay correct across one wrap */
+    ticksPerMs = Read32(last, POWER_DIAG_TICK_RATE) / 256.0;
+    if(ticksPerMs <= 0.0)
+    {
+        ticksPerMs = 32.0;
+    }
+    for(i = 0u; i < POWER_DIAG_STATES; i++)
+    {
+        stateTicks[i] = (double)(uint32)(Read32(last, POWER_DIAG_STATE_TICKS + 4u * i) -
+            Read32(first, POWER_DIAG_STATE_TICKS + 4u * i));
+        totalTicks += stateTicks[i];
+    }
+    for(i = 0u; i < POWER_DEPTH_COUNT; i++)
+    {
+        depthTicks[i] = (double)(uint32)(Read32(last, POWER_DIAG_DEPTH_TICKS + 4u * i) -
+            Read32(first, POWER_DIAG_DEPTH_TICKS + 4u * i));
+        sleepTicks += depthTicks[i];
+    }
+    if(totalTicks <= 0.0)
+    {
+        fprintf(stderr, "powermodel: no time accounted between the records\n");
+        return 1;
+    }
+    
+    /* SLEEP, the last state, is split into the sleep depths measured by PowerManagerSleep */
+    for(i = 0u; i < POWER_DIAG_STATES; i++)
+    {
+        double ticks = stateTicks[i];
+        
+        if(i == (POWER_DIAG_STATES - 1u))
+        {
+            ticks = (ticks > sleepTicks) ? (ticks - sleepTicks) : 0.0;
+        }
+        stateCharge[i] = ticks * stateCurrent[i].current;
+        charge += stateCharge[i];
+    }
+    for(i = 0u; i < POWER_DEPTH_COUNT; i++)
+    {
+        depthCharge[i] = depthTicks[i] * depthCurrent[i].current;
+        charge += depthCharge[i];
+    }
+    if(charge <= 0.0)
+    {
+        charge = 1.0;
+    }
+    
+    printf("%-24s %10s %8s %9s %12s %8s\n", "state", "time s", "time", "entries", "mean us", "charge");
+    for(i = 0u; i < POWER_DIAG_STATES; i++)
+    {
+        entries = (uint16)(Read16(last, POWER_DIAG_ENTRIES + 2u * i) - Read16(first, POWER_DIAG_ENTRIES + 2u * i));
+        printf("%-24s %10.1f %7.2f%% %9u %12.1f %7.2f%%\n", stateCurrent[i].name, stateTicks[i] / ticksPerMs / 1000.0,
+            100.0 * stateTicks[i] / totalTicks, (unsigned int)entries,
+            (entries > 0u) ? (1000.0 * stateTicks[i] / ticksPerMs / entries) : 0.0, 100.0 * stateCharge[i] / charge);
+    }
+    for(i = 0u; i < POWER_DEPTH_COUNT; i++)
+    {
+        printf("  SLEEP %-16s %10.1f %7.2f%% %9s %12s %7.2f%%\n", depthCurrent[i].name, depthTicks[i] / ticksPerMs / 1000.0,
+            100.0 * depthTicks[i] / totalTicks, "", "", 100.0 * depthCharge[i] / charge);
+    }
+    
+    averageCurrent = charge / totalTicks + floorCurrent;
+    hours = batteryMah / averageCurrent;
+    printf("\nILO error %d ppm, range %d to %d ppm over %u measurements\n",
+        (int)(int32)Read32(last, POWER_DIAG_ILO_ERROR), (int)(int32)Read32(last, POWER_DIAG_ILO_ERROR + 4u),
+        (int)(int32)Read32(last, POWER_DIAG_ILO_ERROR + 8u), (unsigned int)Read16(last, POWER_DIAG_ILO_MEASURES));
+    printf("average current %.4f mA, battery %.0f mAh lasts %.0f h (%.1f days)\n",
+        averageCurrent, batteryMah, hours, hours / 24.0);
+    return 0;
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,340 @@
+/*****************************************************************************
+* File Name: profdump.c
+*
+* Version: 1.00
+*
+* Description: Host decoder of the profiler dump: probe statistics, timeline and flame summary.
+*
+* Related Document: Code example CE202479
+*
+* Hardware Dependency: See code example CE202479
+*
+******************************************************************************
+* Copyright (2015), Cypress Semiconductor Corporation.
+******************************************************************************
+* This software is owned by Cypress Semiconductor Corporation (Cypress) and is
+* protected by and subject to worldwide patent protection (United States and
+* foreign), United States copyright laws and international treaty provisions.
+* Cypress hereby grants to licensee a personal, non-exclusive, non-transferable
+* license to copy, use, modify, create derivative works of, and compile the
+* Cypress Source Code and derivative works for the sole purpose of creating
+* custom software in support of licensee product to be used only in conjunction
+* with a Cypress integrated circuit as specified in the applicable agreement.
+* Any reproduction, modification, translation, compilation, or representation of
+* this software except as specified above is prohibited without the express
+* written permission of Cypress.
+*
+* Disclaimer: CYPRESS MAKES NO WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, WITH
+* REGARD TO THIS MATERIAL, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+* Cypress reserves the right to make changes without further notice to the
+* materials described herein. Cypress does not assume any liability arising out
+* of the application or use of any product or circuit described herein. Cypress
+* does not authorize its products for use as critical components in life-support
+* systems where a malfunction or failure may reasonably be expected to result in
+* significant injury to the user. The inclusion of Cypress' product in a life-
+* support systems application implies that the manufacturer assumes all risk of
+* such use and in doing so indemnifies Cypress against all charges. Use may be
+* limited by and subject to the applicable Cypress software license agreement.
+*****************************************************************************/
+/*
+* Build and run from the repository root:
+*   gcc -std=gnu99 -O2 -Ihost -ISmartMop.cydsn -o profdump host/profdump.c
+*   ./profdump DUMP             statistics, timeline and flame summary
+*   ./profdump -f DUMP          folded stacks only, for flamegraph.pl
+* DUMP is the binary UART output of the 'P' command of a PROFILE_ENABLED build, e.g. captured
+* with "cat /dev/ttyACM0 > trace.bin". Without DUMP the dump is read from stdin. Text before
+* the "PRF1" magic is skipped.
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <project.h>
+#include <profile.h>
+
+
+#define DUMP_MAX_LEN    (65536u)
+#define STACK_DEPTH     (PROFILE_PROBE_COUNT)
+
+/* Same order as the PROFILE_PROBE_ constants */
+static const char *probeName[PROFILE_PROBE_COUNT] =
+{
+    "ble_stack",
+    "ble_event",
+    "scheduler",
+    "scan",
+    "filter",
+    "level",
+    "motion",
+    "bmi2_i2c_read",
+    "tracking",
+    "interface",
+};
+
+typedef struct
+{
+    char path[256];
+    double cycles;
+} FOLDED_STACK;
+
+static FOLDED_STACK folded[64];
+static uint32 foldedCount = 0u;
+
+
+static uint32 Read32(const uint8 record[], uint32 offset)
+{
+    return (uint32)record[offset] | ((uint32)record[offset + 1u] << 8) |
+        ((uint32)record[offset + 2u] << 16) | ((uint32)record[offset + 3u] << 24);
+}
+
+static uint16 Read16(const uint8 record[], uint32 offset)
+{
+    return (uint16)(record[offset] | (record[offset + 1u] << 8));
+}
+
+static const char *ProbeName(uint32 probe)
+{
+    return (probe < PROFILE_PROBE_COUNT) ? probeName[probe] : "unknown";
+}
+
+/*******************************************************************************
+* Function Name: AddFolded
+********************************************************************************/
+/* Add self cycles to a folded stack "outer;inner". */
+static void AddFolded(const uint32 stack[], uint32 depth, double cycles)
+{
+    char path[256] = "";
+    uint32 i;
+    
+    for(i = 0u; i < depth; i++)
+    {
+        strncat(path, (i > 0u) ? ";" : "", sizeof(path) - strlen(path) - 1u);
+        strncat(path, ProbeName(stack[i]), sizeof(path) - strlen(path) - 1u);
+    }
+    for(i = 0u; i < foldedCount; i++)
+    {
+        if(strcmp(folded[i].path, path) == 0)
+        {
+            folded[i].cycles += cycles;
+            return;
+        }
+    }
+    if(foldedCount < (sizeof(folded) / sizeof(folded[0])))
+    {
+        strcpy(folded[foldedCount].path, path);
+        folded[foldedCount].cycles = cycles;
+        foldedCount++;
+    }
+}
+
+static int CompareFolded(const void *a, const void *b)
+{
+    double difference = ((const FOLDED_STACK *)b)->cycles - ((const FOLDED_STACK *)a)->cycles;
+    
+    return (difference > 0.0) ? 1 : ((difference < 0.0) ? -1 : 0);
+}
+
+/*******************************************************************************
+* Function Name: ReplayEvents
+********************************************************************************/
+/* Walk the trace, print the timeline when asked and fold the self time of every */
+/* closed probe into its stack. Begin events lost at the start of the ring leave  */
+/* end events without a begin, these are only printed.                           */
+static void ReplayEvents(const uint8 dump[], uint32 offset, uint32 count, double cyclesPerUs, int printTimeline)
+{
+    uint32 stack[STACK_DEPTH];
+    double stackBegin[STACK_DEPTH];
+    double childCycles[STACK_DEPTH];
+    uint32 depth = 0u;
+    uint32 i;
+    uint32 level;
+    uint32 event;
+    uint32 probe;
+    uint32 stamp;
+    uint32 previous = 0u;
+    double now = 0.0;
+    double inclusive;
+    
+    for(i = 0u; i < count; i++)
+    {
+        event = Read32(dump, offset + (4u * i));
+        probe = event >> PROFILE_EVENT_PROBE_SHIFT;
+        stamp = event & PROFILE_TIMER_MASK;
+        if(i > 0u)
+        {
+            now += (double)((stamp - previous) & PROFILE_TIMER_MASK);
+        }
+        previous = stamp;
+        
+        if(((event >> PROFILE_EVENT_TYPE_SHIFT) & 1u) == PROFILE_EVENT_BEGIN)
+        {
+            if(printTimeline)
+            {
+                printf("%12.1f %*s+ %s\n", now / cyclesPerUs, (int)(2u * depth), "", ProbeName(probe));
+            }
+            if(depth < STACK_DEPTH)
+            {
+                stack[depth] = probe;
+                stackBegin[depth] = now;
+                childCycles[depth] = 0.0;
+                depth++;
+            }
+            continue;
+        }
+        
+        /* Close the probe and everything opened inside it that was never closed */
+        for(level = depth; (level > 0u) && (stack[level - 1u] != probe); level--)
+        {
+        }
+        if(level == 0u)
+        {
+            if(printTimeline)
+            {
+                printf("%12.1f %*s- %s (begin not in the trace)\n", now / cyclesPerUs, (int)(2u * depth), "", ProbeName(probe));
+            }
+            continue;
+        }
+        depth = level - 1u;
+        inclusive = now - stackBegin[depth];
+        AddFolded(stack, depth + 1u, inclusive - childCycles[depth]);
+        if(depth > 0u)
+        {
+            childCycles[depth - 1u] += inclusive;
+        }
+        if(printTimeline)
+        {
+            printf("%12.1f %*s- %s %.1f us\n", now / cyclesPerUs, (int)(2u * depth), "", ProbeName(probe),
+                inclusive / cyclesPerUs);
+        }
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    static uint8 dump[DUMP_MAX_LEN];
+    FILE *file = stdin;
+    int foldedOnly = 0;
+    int arg;
+    size_t length;
+    uint32 start;
+    uint32 offset;
+    uint32 end;
+    uint32 i;
+    uint32 bin;
+    uint32 probe;
+    uint32 probeCount;
+    uint32 bins;
+    uint32 base;
+    uint32 eventCount;
+    uint32 count;
+    uint16 checksum = 0u;
+    double cyclesPerUs;
+    double sum;
+    double total;
+    
+    for(arg = 1; arg < argc; arg++)
+    {
+        if(strcmp(argv[arg], "-f") == 0)
+        {
+            foldedOnly = 1;
+        }
+        else if((file = fopen(argv[arg], "rb")) == NULL)
+        {
+            fprintf(stderr, "profdump: cannot open %s\n", argv[arg]);
+            return 1;
+        }
+    }
+    length = fread(dump, 1u, sizeof(dump), file);
+    
+    /* Find the magic */
+    for(start = 0u; (start + PROFILE_DUMP_HEADER_LEN) <= length; start++)
+    {
+        if(memcmp(&dump[start], PROFILE_DUMP_MAGIC, 4u) == 0)
+        {
+            break;
+        }
+    }
+    if((start + PROFILE_DUMP_HEADER_LEN) > length)
+    {
+        fprintf(stderr, "profdump: no profiler dump found\n");
+        return 1;
+    }
+    
+    offset = start + 4u;
+    cyclesPerUs = Read32(dump, offset) / 1e6;
+    probeCount = dump[offset + 4u];
+    bins = dump[offset + 5u];
+    base = Read16(dump, offset + 6u);
+    eventCount = Read16(dump, offset + 8u);
+    offset = start + PROFILE_DUMP_HEADER_LEN;
+    end = offset + (probeCount * (20u + (2u * bins))) + (4u * eventCount);
+    if((probeCount > PROFILE_PROBE_COUNT) || ((end + 2u) > length))
+    {
+        fprintf(stderr, "profdump: truncated dump\n");
+        return 1;
+    }
+    for(i = start; i < end; i++)
+    {
+        checksum += dump[i];
+    }
+    if(checksum != Read16(dump, end))
+    {
+        fprintf(stderr, "profdump: checksum mismatch\n");
+        return 1;
+    }
+    
+    if(!foldedOnly)
+    {
+        printf("%-14s %8s %10s %10s %10s %10s  histogram from %u cycles, doubling\n", "probe", "count",
+            "min us", "mean us", "max us", "total ms", base);
+    }
+    for(probe = 0u; probe < probeCount; probe++)
+    {
+        count = Read32(dump, offset);
+        sum = Read32(dump, offset + 12u) + (4294967296.0 * Read32(dump, offset + 16u));
+        if(!foldedOnly && (count > 0u))
+        {
+            printf("%-14s %8u %10.1f %10.1f %10.1f %10.2f ", ProbeName(probe), count,
+                Read32(dump, offset + 4u) / cyclesPerUs, (sum / count) / cyclesPerUs,
+                Read32(dump, offset + 8u) / cyclesPerUs, sum / (cyclesPerUs * 1000.0));
+            for(bin = 0u; bin < bins; bin++)
+            {
+                printf(" %u", Read16(dump, offset + 20u + (2u * bin)));
+            }
+            printf("\n");
+        }
+        offset += 20u + (2u * bins);
+    }
+    
+    if(!foldedOnly)
+    {
+        printf("\ntimeline, %u events, us\n", eventCount);
+    }
+    ReplayEvents(dump, offset, eventCount, cyclesPerUs, !foldedOnly);
+    
+    qsort(folded, foldedCount, sizeof(folded[0]), CompareFolded);
+    total = 0.0;
+    for(i = 0u; i < foldedCount; i++)
+    {
+        total += folded[i].cycles;
+    }
+    if(!foldedOnly)
+    {
+        printf("\nflame summary of the timeline, self time\n");
+    }
+    for(i = 0u; i < foldedCount; i++)
+    {
+        if(foldedOnly)
+        {
+            printf("%s %.0f\n", folded[i].path, folded[i].cycles);
+        }
+        else
+        {
+            printf("%-40s %10.1f us %6.1f%%\n", folded[i].path, folded[i].cycles / cyclesPerUs,
+                (100.0 * folded[i].cycles) / ((total > 0.0) ? total : 1.0));
+        }
+    }
+    return 0;
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,94 @@
+/*****************************************************************************
+* File Name: project.h
+*
+* Version: 1.00
+*
+* Description: Host build replacement for the PSoC Creator generated project.h. Provides the PSoC types and a simulated CapSense_CSD API so the level pipeline can run on a PC.
+*
+* Related Document: Code example CE202479
+*
+* Hardware Dependency: See code example CE202479
+*
+******************************************************************************
+* Copyright (2015), Cypress Semiconductor Corporation.
+******************************************************************************
+* This software is owned by Cypress Semiconductor Corporation (Cypress) and is
+* protected by and subject to worldwide patent protection (United States and
+* foreign), United States copyright laws and international treaty provisions.
+* Cypress hereby grants to licensee a personal, non-exclusive, non-transferable
+* license to copy, use, modify, create derivative works of, and compile the
+* Cypress Source Code and derivative works for the sole purpose of creating
+* custom software in support of licensee product to be used only in conjunction
+* with a Cypress integrated circuit as specified in the applicable agreement.
+* Any reproduction, modification, translation, compilation, or representation of
+* this software except as specified above is prohibited without the express
+* written permission of Cypress.
+*
+* Disclaimer: CYPRESS MAKES NO WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, WITH
+* REGARD TO THIS MATERIAL, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+* Cypress reserves the right to make changes without further notice to the
+* materials described herein. Cypress does not assume any liability arising out
+* of the application or use of any product or circuit described herein. Cypress
+* does not authorize its products for use as critical components in life-support
+* systems where a malfunction or failure may reasonably be expected to result in
+* significant injury to the user. The inclusion of Cypress' product in a life-
+* support systems application implies that the manufacturer assumes all risk of
+* such use and in doing so indemnifies Cypress against all charges. Use may be
+* limited by and subject to the applicable Cypress software license agreement.
+*****************************************************************************/
+#if !defined(_HOST_PROJECT_H)
+#define _HOST_PROJECT_H
+
+#include <stdint.h>
+#include <string.h>
+
+
+/* PSoC Creator types (cytypes.h) */
+typedef uint8_t     uint8;
+typedef uint16_t    uint16;
+typedef uint32_t    uint32;
+typedef int8_t      int8;
+typedef int16_t     int16;
+typedef int32_t     int32;
+typedef uint32      cystatus;
+
+#define CYCODE
+#define CYRET_SUCCESS       (0x00u)
+#define CYRET_BAD_PARAM     (0x01u)
+#define CYRET_UNKNOWN       (0x02u)
+#define LO8(x)              ((uint8)((x) & 0xFFu))
+#define HI8(x)              ((uint8)((uint16)(x) >> 8))
+#define LO16(x)             ((uint16)((x) & 0xFFFFu))
+#define HI16(x)             ((uint16)((uint32)(x) >> 16))
+
+/* Flash geometry of the CY8C4248LQI-BL583 used by main.h */
+#define CYDEV_FLASH_BASE        (0x00000000u)
+#define CYDEV_FLASH_SIZE        (0x00040000u)
+#define CY_FLASH_SIZEOF_ARRAY   (0x00040000u)
+#define CY_FLASH_SIZEOF_ROW     (0x00000080u)
+
+/* BLE component, the attribute handles the firmware notifies through. Defined by the host program */
+#define CYBLE_GATT_MTU          (136u)
+typedef struct
+{
+    uint16 customServiceCharHandle;
+    uint16 customServiceCharDescriptors[1];
+} CYBLE_CUSTOMS_INFO_T;
+typedef struct
+{
+    uint16 customServiceHandle;
+    CYBLE_CUSTOMS_INFO_T customServiceInfo[7];
+} CYBLE_CUSTOMS_T;
+extern CYBLE_CUSTOMS_T cyBle_customs[];
+
+/* Simulated CapSense_CSD component. See capsense_sim.c */
+uint16 CapSense_CSD_ReadSensorRaw(uint32 sensor);
+void CapSense_CSD_ScanEnabledWidgets(void);
+uint32 CapSense_CSD_IsBusy(void);
+void CapSense_CSD_EnableWidget(uint32 widget);
+void CapSense_CSD_DisableWidget(uint32 widget);
+
+#endif /* _HOST_PROJECT_H */
+
+/* [] END OF FILE */
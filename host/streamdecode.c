@@ -0,0 +1,198 @@
+/*****************************************************************************
+* File Name: streamdecode.c
+*
+* Version: 1.00
+*
+* Description: Host decoder of the raw sensor stream notifications, shared by streamdump and streamtest.
+*
+* Related Document: Code example CE202479
+*
+* Hardware Dependency: See code example CE202479
+*
+******************************************************************************
+* Copyright (2015), Cypress Semiconductor Corporation.
+******************************************************************************
+* This software is owned by Cypress Semiconductor Corporation (Cypress) and is
+* protected by and subject to worldwide patent protection (United States and
+* foreign), United States copyright laws and international treaty provisions.
+* Cypress hereby grants to licensee a personal, non-exclusive, non-transferable
+* license to copy, use, modify, create derivative works of, and compile the
+* Cypress Source Code and derivative works for the sole purpose of creating
+* custom software in support of licensee product to be used only in conjunction
+* with a Cypress integrated circuit as specified in the applicable agreement.
+* Any reproduction, modification, translation, compilation, or representation of
+* this software except as specified above is prohibited without the express
+* written permission of Cypress.
+*
+* Disclaimer: CYPRESS MAKES NO WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, WITH
+* REGARD TO THIS MATERIAL, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+* Cypress reserves the right to make changes without further notice to the
+* materials described herein. Cypress does not assume any liability arising out
+* of the application or use of any product or circuit described herein. Cypress
+* does not authorize its products for use as critical components in life-support
+* systems where a malfunction or failure may reasonably be expected to result in
+* significant injury to the user. The inclusion of Cypress' product in a life-
+* support systems application implies that the manufacturer assumes all risk of
+* such use and in doing so indemnifies Cypress against all charges. Use may be
+* limited by and subject to the applicable Cypress software license agreement.
+*****************************************************************************/
+#include <string.h>
+#include <project.h>
+#include <stream.h>
+#include "streamdecode.h"
+
+
+static const char *fieldName[STREAM_FIELD_COUNT] = { "raw", "diff", "processed" };
+
+static uint32 Read32(const uint8 *data)
+{
+    return (uint32)data[0] | ((uint32)data[1] << 8) | ((uint32)data[2] << 16) | ((uint32)data[3] << 24);
+}
+
+/* Varint at data[*offset], 0 and FALSE when the notification ends before it does */
+static uint8 ReadVarint(const uint8 *data, uint16 length, uint16 *offset, uint32 *value)
+{
+    uint8 shift = 0u;
+    
+    *value = 0u;
+    while((*offset < length) && (shift < 35u))
+    {
+        *value |= (uint32)(data[*offset] & 0x7Fu) << shift;
+        shift += 7u;
+        if((data[(*offset)++] & 0x80u) == 0u)
+        {
+            return TRUE;
+        }
+    }
+    return FALSE;
+}
+
+/* Write the frames of the notifications in capture, each preceded by its length as uint16 little */
+/* endian, to csv. Lost notifications are reported on stderr, the frames after them are skipped   */
+/* until the next keyframe.                                                                        */
+void StreamDecode(FILE *capture, FILE *csv, STREAM_DECODE_STATS *stats)
+{
+    static uint8 data[65536];
+    uint8 lengthBytes[2];
+    uint16 length;
+    uint16 offset;
+    uint8 fields = 0u;
+    uint8 csvFields = 0u;
+    uint8 synced = FALSE;
+    uint8 complete;
+    uint8 sequence = 0u;
+    uint8 count;
+    uint8 frameIndex;
+    uint8 field;
+    uint8 sensor;
+    uint32 delta;
+    uint32 frame = 0u;
+    uint32 timeMs = 0u;
+    int32 value[STREAM_FIELD_COUNT][NUMSENSORS];
+    
+    memset(stats, 0, sizeof(*stats));
+    memset(value, 0, sizeof(value));
+    
+    while(fread(lengthBytes, 1, 2, capture) == 2)
+    {
+        length = (uint16)(lengthBytes[0] | (lengthBytes[1] << 8));
+        if(fread(data, 1, length, capture) != length)
+        {
+            fprintf(stderr, "truncated capture\n");
+            break;
+        }
+        if(length < STREAM_NTF_FRAMES)
+        {
+            fprintf(stderr, "notification of %u bytes ignored\n", length);
+            continue;
+        }
+        stats->notifications++;
+        
+        if(synced && (data[STREAM_NTF_SEQUENCE] != sequence))
+        {
+            stats->lost += (uint8)(data[STREAM_NTF_SEQUENCE] - sequence);
+            fprintf(stderr, "notifications %u to %u lost\n", sequence, (uint8)(data[STREAM_NTF_SEQUENCE] - 1u));
+            synced = FALSE;
+        }
+        sequence = data[STREAM_NTF_SEQUENCE] + 1u;
+        fields = data[STREAM_NTF_FLAGS] & STREAM_FIELD_ALL;
+        if(data[STREAM_NTF_FLAGS] & STREAM_FLAG_KEYFRAME)
+        {
+            synced = TRUE;
+        }
+        if(!synced)
+        {
+            stats->skipped += data[STREAM_NTF_COUNT];
+            continue;
+        }
+        
+        /* The header line lists the fields of the first decoded notification */
+        if(csvFields != fields)
+        {
+            csvFields = fields;
+            fprintf(csv, "frame,time_ms");
+            for(field = 0u; field < STREAM_FIELD_COUNT; field++)
+            {
+                for(sensor = 0u; (fields & (1u << field)) && (sensor < NUMSENSORS); sensor++)
+                {
+                    fprintf(csv, ",%s%u", fieldName[field], sensor);
+                }
+            }
+            fprintf(csv, "\n");
+        }
+        
+        frame = Read32(&data[STREAM_NTF_FRAME]);
+        timeMs = Read32(&data[STREAM_NTF_TIME]);
+        count = data[STREAM_NTF_COUNT];
+        offset = STREAM_NTF_FRAMES;
+        for(frameIndex = 0u; frameIndex < count; frameIndex++)
+        {
+            complete = ReadVarint(data, length, &offset, &delta);
+            frame += delta;
+            complete = complete && ReadVarint(data, length, &offset, &delta);
+            timeMs += delta;
+            for(field = 0u; field < STREAM_FIELD_COUNT; field++)
+            {
+                for(sensor = 0u; complete && (fields & (1u << field)) && (sensor < NUMSENSORS); sensor++)
+                {
+                    complete = ReadVarint(data, length, &offset, &delta);
+                    
+                    /* The first frame of a keyframe is absolute, the others are changes. Undo the zigzag */
+                    if((frameIndex == 0u) && (data[STREAM_NTF_FLAGS] & STREAM_FLAG_KEYFRAME))
+                    {
+                        value[field][sensor] = 0;
+                    }
+                    value[field][sensor] += (int32)(delta >> 1) ^ -(int32)(delta & 1u);
+                }
+            }
+            if(!complete)
+            {
+                break;
+            }
+            
+            fprintf(csv, "%u,%u", frame, timeMs);
+            for(field = 0u; field < STREAM_FIELD_COUNT; field++)
+            {
+                for(sensor = 0u; (fields & (1u << field)) && (sensor < NUMSENSORS); sensor++)
+                {
+                    fprintf(csv, ",%d", value[field][sensor]);
+                }
+            }
+            fprintf(csv, "\n");
+            stats->frames++;
+        }
+        if(frameIndex < count)
+        {
+            fprintf(stderr, "notification %u ends after %u of %u frames\n", data[STREAM_NTF_SEQUENCE], frameIndex, count);
+            synced = FALSE;
+        }
+        else if(offset != length)
+        {
+            fprintf(stderr, "notification %u has %u bytes after the last frame\n", data[STREAM_NTF_SEQUENCE], length - offset);
+        }
+        stats->frameBytes += offset - STREAM_NTF_FRAMES;
+    }
+}
+
+/* [] END OF FILE */
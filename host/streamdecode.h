@@ -0,0 +1,62 @@
+/*****************************************************************************
+* File Name: streamdecode.h
+*
+* Version: 1.00
+*
+* Description: Host decoder of the raw sensor stream notifications, shared by streamdump and streamtest.
+*
+* Related Document: Code example CE202479
+*
+* Hardware Dependency: See code example CE202479
+*
+******************************************************************************
+* Copyright (2015), Cypress Semiconductor Corporation.
+******************************************************************************
+* This software is owned by Cypress Semiconductor Corporation (Cypress) and is
+* protected by and subject to worldwide patent protection (United States and
+* foreign), United States copyright laws and international treaty provisions.
+* Cypress hereby grants to licensee a personal, non-exclusive, non-transferable
+* license to copy, use, modify, create derivative works of, and compile the
+* Cypress Source Code and derivative works for the sole purpose of creating
+* custom software in support of licensee product to be used only in conjunction
+* with a Cypress integrated circuit as specified in the applicable agreement.
+* Any reproduction, modification, translation, compilation, or representation of
+* this software except as specified above is prohibited without the express
+* written permission of Cypress.
+*
+* Disclaimer: CYPRESS MAKES NO WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, WITH
+* REGARD TO THIS MATERIAL, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+* Cypress reserves the right to make changes without further notice to the
+* materials described herein. Cypress does not assume any liability arising out
+* of the application or use of any product or circuit described herein. Cypress
+* does not authorize its products for use as critical components in life-support
+* systems where a malfunction or failure may reasonably be expected to result in
+* significant injury to the user. The inclusion of Cypress' product in a life-
+* support systems application implies that the manufacturer assumes all risk of
+* such use and in doing so indemnifies Cypress against all charges. Use may be
+* limited by and subject to the applicable Cypress software license agreement.
+*****************************************************************************/
+#if !defined(_STREAMDECODE_H)
+#define _STREAMDECODE_H
+
+#include <stdio.h>
+#include <project.h>
+
+
+/* Totals of a decoded capture */
+typedef struct
+{
+    unsigned long notifications;    /* Notifications read */
+    unsigned long frames;           /* Frames written to the CSV */
+    unsigned long lost;             /* Notifications missing from the sequence */
+    unsigned long skipped;          /* Frames skipped until the next keyframe */
+    unsigned long frameBytes;       /* Bytes of the decoded frames, without the notification headers */
+} STREAM_DECODE_STATS;
+
+/* Function prototypes */
+void StreamDecode(FILE *capture, FILE *csv, STREAM_DECODE_STATS *stats);
+
+#endif /* _STREAMDECODE_H */
+
+/* [] END OF FILE */
@@ -0,0 +1,86 @@
+/*****************************************************************************
+* File Name: streamdump.c
+*
+* Version: 1.00
+*
+* Description: Host decoder of the raw sensor stream notifications: rebuilds the full trace as CSV.
+*
+* Related Document: Code example CE202479
+*
+* Hardware Dependency: See code example CE202479
+*
+******************************************************************************
+* Copyright (2015), Cypress Semiconductor Corporation.
+******************************************************************************
+* This software is owned by Cypress Semiconductor Corporation (Cypress) and is
+* protected by and subject to worldwide patent protection (United States and
+* foreign), United States copyright laws and international treaty provisions.
+* Cypress hereby grants to licensee a personal, non-exclusive, non-transferable
+* license to copy, use, modify, create derivative works of, and compile the
+* Cypress Source Code and derivative works for the sole purpose of creating
+* custom software in support of licensee product to be used only in conjunction
+* with a Cypress integrated circuit as specified in the applicable agreement.
+* Any reproduction, modification, translation, compilation, or representation of
+* this software except as specified above is prohibited without the express
+* written permission of Cypress.
+*
+* Disclaimer: CYPRESS MAKES NO WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, WITH
+* REGARD TO THIS MATERIAL, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+* Cypress reserves the right to make changes without further notice to the
+* materials described herein. Cypress does not assume any liability arising out
+* of the application or use of any product or circuit described herein. Cypress
+* does not authorize its products for use as critical components in life-support
+* systems where a malfunction or failure may reasonably be expected to result in
+* significant injury to the user. The inclusion of Cypress' product in a life-
+* support systems application implies that the manufacturer assumes all risk of
+* such use and in doing so indemnifies Cypress against all charges. Use may be
+* limited by and subject to the applicable Cypress software license agreement.
+*****************************************************************************/
+/*
+* Build and run from the repository root:
+*   gcc -std=gnu99 -O2 -Ihost -ISmartMop.cydsn -o streamdump host/streamdump.c host/streamdecode.c
+*   ./streamdump CAPTURE > trace.csv
+* CAPTURE holds the values of the stream characteristic notifications in the order received,
+* each preceded by its length as uint16 little endian. Without CAPTURE it is read from stdin.
+* The CSV has one line per frame: frame, time in ms, then the raw, diff and processed counts of
+* every sensor that the notifications carry. Lost notifications are reported on stderr, the
+* frames after them are skipped until the next keyframe.
+*/
+#include <stdio.h>
+#include <project.h>
+#include "streamdecode.h"
+
+
+int main(int argc, char *argv[])
+{
+    FILE *file = stdin;
+    STREAM_DECODE_STATS stats;
+    
+    if(argc > 1)
+    {
+        file = fopen(argv[1], "rb");
+        if(file == NULL)
+        {
+            perror(argv[1]);
+            return 1;
+        }
+    }
+    
+    StreamDecode(file, stdout, &stats);
+    
+    fprintf(stderr, "%lu notifications, %lu frames, %lu notifications lost, %lu frames skipped\n",
+        stats.notifications, stats.frames, stats.lost, stats.skipped);
+    if(stats.frames > 0u)
+    {
+        fprintf(stderr, "%.1f bytes per frame, %.1f frames per notification\n",
+            (double)stats.frameBytes / stats.frames, (double)stats.frames / stats.notifications);
+    }
+    if(file != stdin)
+    {
+        fclose(file);
+    }
+    return 0;
+}
+
+/* [] END OF FILE */
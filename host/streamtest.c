@@ -0,0 +1,288 @@
+/*****************************************************************************
+* File Name: streamtest.c
+*
+* Version: 1.00
+*
+* Description: Host round-trip test of the raw sensor stream: encodes with stream.c, decodes with streamdecode.c.
+*
+* Related Document: Code example CE202479
+*
+* Hardware Dependency: See code example CE202479
+*
+******************************************************************************
+* Copyright (2015), Cypress Semiconductor Corporation.
+******************************************************************************
+* This software is owned by Cypress Semiconductor Corporation (Cypress) and is
+* protected by and subject to worldwide patent protection (United States and
+* foreign), United States copyright laws and international treaty provisions.
+* Cypress hereby grants to licensee a personal, non-exclusive, non-transferable
+* license to copy, use, modify, create derivative works of, and compile the
+* Cypress Source Code and derivative works for the sole purpose of creating
+* custom software in support of licensee product to be used only in conjunction
+* with a Cypress integrated circuit as specified in the applicable agreement.
+* Any reproduction, modification, translation, compilation, or representation of
+* this software except as specified above is prohibited without the express
+* written permission of Cypress.
+*
+* Disclaimer: CYPRESS MAKES NO WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, WITH
+* REGARD TO THIS MATERIAL, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+* Cypress reserves the right to make changes without further notice to the
+* materials described herein. Cypress does not assume any liability arising out
+* of the application or use of any product or circuit described herein. Cypress
+* does not authorize its products for use as critical components in life-support
+* systems where a malfunction or failure may reasonably be expected to result in
+* significant injury to the user. The inclusion of Cypress' product in a life-
+* support systems application implies that the manufacturer assumes all risk of
+* such use and in doing so indemnifies Cypress against all charges. Use may be
+* limited by and subject to the applicable Cypress software license agreement.
+*****************************************************************************/
+/*
+* Build and run from the repository root:
+*   gcc -std=gnu99 -O2 -Ihost -ISmartMop.cydsn -o streamtest host/streamtest.c host/streamdecode.c \
+*       SmartMop.cydsn/stream.c
+*   ./streamtest
+* Every case streams STREAMTEST_FRAMES synthetic frames through the firmware encoder, decodes the
+* notifications and compares each decoded frame with the values the encoder saw. Exits with 1
+* when a frame differs, a queued frame is missing or the stream starts at the default MTU.
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <project.h>
+#include <main.h>
+#include <notify.h>
+#include <stream.h>
+#include "streamdecode.h"
+
+
+#define STREAMTEST_FRAMES       (2000u)
+#define STREAMTEST_LINE_LEN     (512u)
+
+/* Globals owned by main.c and BLEApplications.c on the target */
+uint16 sensorRaw[NUMSENSORS];
+int16 sensorDiff[NUMSENSORS];
+int16 sensorProcessed[NUMSENSORS];
+uint32 frameCount = 0u;
+uint16 NegotiatedMtu = DEFAULT_MTU_LEN;
+volatile uint32 systemTimeMs = 0u;
+CYBLE_CUSTOMS_T cyBle_customs[1];
+
+/* Stream globals */
+extern uint8 streamFields;
+extern uint32 streamFrameCount;
+extern uint32 streamDroppedFrames;
+extern uint32 streamByteCount;
+extern uint32 streamRefusedCount;
+
+/* Test case */
+typedef struct
+{
+    const char *name;
+    uint8 fields;           /* STREAM_FIELD_ bits of the first half */
+    uint8 fieldsLater;      /* STREAM_FIELD_ bits of the second half */
+    uint32 failEvery;       /* Every failEvery-th notification is refused by the queue, 0 for none */
+} STREAMTEST_CASE;
+
+static const STREAMTEST_CASE testCase[] =
+{
+    { "all fields",     STREAM_FIELD_ALL,   STREAM_FIELD_ALL,   0u },
+    { "raw only",       STREAM_FIELD_RAW,   STREAM_FIELD_RAW,   0u },
+    { "field change",   STREAM_FIELD_ALL,   STREAM_FIELD_RAW,   0u },
+    { "queue full",     STREAM_FIELD_ALL,   STREAM_FIELD_ALL,   7u }
+};
+
+static FILE *testCapture;
+static uint32 testPuts;
+static uint32 testFailEvery;
+static uint32 testRandom = 0x12345678u;
+
+
+/* Notification queue of the target: the notification values go to the capture */
+uint8 NotifyQueuePut(uint16 handle, const uint8 data[], uint16 length, uint8 coalesce, NOTIFY_SEND_HANDLER send, NOTIFY_DONE_HANDLER done)
+{
+    (void)handle;
+    (void)coalesce;
+    (void)send;
+    (void)done;
+    
+    testPuts++;
+    if((testFailEvery != 0u) && ((testPuts % testFailEvery) == 0u))
+    {
+        return FALSE;
+    }
+    fputc(LO8(length), testCapture);
+    fputc(HI8(length), testCapture);
+    fwrite(data, 1, length, testCapture);
+    return TRUE;
+}
+
+uint8 NotifyQueueSpace(void)
+{
+    return NOTIFY_QUEUE_DEPTH;
+}
+
+void ConnectionMarkActivity(void)
+{
+}
+
+static uint32 TestRandom(uint32 range)
+{
+    testRandom = testRandom * 1103515245u + 12345u;
+    return (testRandom >> 16) % range;
+}
+
+/* CSV line of the current frame, as streamdump writes it */
+static void FormatFrame(char *line, uint8 fields)
+{
+    uint8 sensor;
+    int length;
+    
+    length = sprintf(line, "%u,%u", frameCount, systemTimeMs);
+    for(sensor = 0u; (fields & STREAM_FIELD_RAW) && (sensor < NUMSENSORS); sensor++)
+    {
+        length += sprintf(&line[length], ",%d", sensorRaw[sensor]);
+    }
+    for(sensor = 0u; (fields & STREAM_FIELD_DIFF) && (sensor < NUMSENSORS); sensor++)
+    {
+        length += sprintf(&line[length], ",%d", sensorDiff[sensor]);
+    }
+    for(sensor = 0u; (fields & STREAM_FIELD_PROCESSED) && (sensor < NUMSENSORS); sensor++)
+    {
+        length += sprintf(&line[length], ",%d", sensorProcessed[sensor]);
+    }
+    sprintf(&line[length], "\n");
+}
+
+/* Stream one case and compare the decoded trace with the frames recorded. Returns the errors */
+static uint32 RunCase(const STREAMTEST_CASE *test)
+{
+    static char reference[STREAMTEST_FRAMES][STREAMTEST_LINE_LEN];
+    char line[STREAMTEST_LINE_LEN];
+    FILE *csv = tmpfile();
+    STREAM_DECODE_STATS stats;
+    uint32 frame;
+    uint32 next = 0u;
+    uint32 errors = 0u;
+    uint8 sensor;
+    
+    testCapture = tmpfile();
+    if((testCapture == NULL) || (csv == NULL))
+    {
+        perror("tmpfile");
+        exit(1);
+    }
+    testPuts = 0u;
+    testFailEvery = test->failEvery;
+    streamFrameCount = 0u;
+    streamDroppedFrames = 0u;
+    streamByteCount = 0u;
+    streamFields = test->fields;
+    NegotiatedMtu = MTU_XCHANGE_DATA_LEN;
+    StreamStart();
+    
+    for(sensor = 0u; sensor < NUMSENSORS; sensor++)
+    {
+        sensorRaw[sensor] = (uint16)(1000u + 150u * sensor);
+    }
+    for(frame = 0u; frame < STREAMTEST_FRAMES; frame++)
+    {
+        /* Skipped frames and a jittering frame period, noise and steps in the counts */
+        frameCount += 1u + (TestRandom(5u) == 0u);
+        systemTimeMs += 40u + TestRandom(3u);
+        for(sensor = 0u; sensor < NUMSENSORS; sensor++)
+        {
+            sensorRaw[sensor] += (uint16)TestRandom(7u) - 3u;
+            if(TestRandom(200u) == 0u)
+            {
+                sensorRaw[sensor] += 400u;
+            }
+            sensorDiff[sensor] = (int16)(sensorRaw[sensor] - 1000u - 100u * sensor);
+            sensorProcessed[sensor] = (int16)((sensorDiff[sensor] * 3) / 2);
+        }
+        if(frame == (STREAMTEST_FRAMES / 2u))
+        {
+            streamFields = test->fieldsLater;
+        }
+        StreamRecord();
+        FormatFrame(reference[frame], streamFields);
+    }
+    StreamStop();
+    
+    rewind(testCapture);
+    StreamDecode(testCapture, csv, &stats);
+    fclose(testCapture);
+    
+    /* Each decoded frame matches the frame of the same number, in order */
+    rewind(csv);
+    while(fgets(line, sizeof(line), csv) != NULL)
+    {
+        if(strncmp(line, "frame,", 6u) == 0)
+        {
+            continue;
+        }
+        frame = (uint32)strtoul(line, NULL, 10);
+        while((next < STREAMTEST_FRAMES) && ((uint32)strtoul(reference[next], NULL, 10) != frame))
+        {
+            next++;
+        }
+        if(next == STREAMTEST_FRAMES)
+        {
+            printf("  frame %u decoded out of order\n", frame);
+            errors++;
+            break;
+        }
+        if(strcmp(line, reference[next]) != 0)
+        {
+            if(errors < 5u)
+            {
+                printf("  frame %u differs\n    sent    %s    decoded %s", frame, reference[next], line);
+            }
+            errors++;
+        }
+        next++;
+    }
+    fclose(csv);
+    
+    /* The frames still batched when the stream stopped are never sent */
+    if(stats.frames != streamFrameCount)
+    {
+        printf("  %u frames queued, %lu decoded\n", streamFrameCount, stats.frames);
+        errors++;
+    }
+    if((test->failEvery == 0u) && ((streamDroppedFrames != 0u) || (stats.lost != 0u)))
+    {
+        printf("  %u frames dropped without a full queue\n", streamDroppedFrames);
+        errors++;
+    }
+    
+    printf("%-14s %4u frames queued, %4u dropped, %5.1f bytes per frame, %4.1f frames per notification: %s\n",
+        test->name, streamFrameCount, streamDroppedFrames,
+        (stats.frames > 0u) ? (double)stats.frameBytes / stats.frames : 0.0,
+        (stats.notifications > 0u) ? (double)stats.frames / stats.notifications : 0.0,
+        (errors == 0u) ? "pass" : "FAIL");
+    return errors;
+}
+
+int main(void)
+{
+    uint32 errors = 0u;
+    uint32 index;
+    
+    /* A keyframe of all fields does not fit the default MTU, the stream is refused */
+    NegotiatedMtu = DEFAULT_MTU_LEN;
+    if(StreamStart() || (streamRefusedCount != 1u))
+    {
+        printf("stream started at the default MTU: FAIL\n");
+        errors++;
+    }
+    
+    for(index = 0u; index < (sizeof(testCase) / sizeof(testCase[0])); index++)
+    {
+        errors += RunCase(&testCase[index]);
+    }
+    
+    return (errors == 0u) ? 0 : 1;
+}
+
+/* [] END OF FILE */